@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <random>
+#include "AtlasBenchmark.h"
+#include "../Fractal/AtlasRenderer.h"
+#include "../Multithreading/PerfProfiler.h"
+
+namespace
+{
+    constexpr int thumbnail_size = 64;
+    constexpr int julia_grid_size = 32;
+    constexpr Real julia_half_size = 1.6L;
+    constexpr std::size_t bookmarks_count = 1024;
+    constexpr std::size_t min_bookmark_escape = 32;
+    constexpr double min_bookmark_decade = -12;
+    constexpr double max_bookmark_decade = -1;
+    constexpr std::size_t bench_iterations_count = 500;
+    constexpr int bench_repeats_count = 3;
+    constexpr std::mt19937::result_type random_seed = 46;
+
+    Axis thumbnailAxis(Complex center, Real half_size)
+    {
+        return Axis { PlaneBorders<Real> { MinMax<Real> { center.re - half_size, center.re + half_size },
+                                           MinMax<Real> { center.im - half_size, center.im + half_size }},
+                      PlaneBorders<int> { MinMax<int> { 0, thumbnail_size }, MinMax<int> { 0, thumbnail_size }}};
+    }
+
+    // Constants at the centers of a grid over the start view
+    std::vector<AtlasJob> makeJuliaAtlas(Axis const& start_axis)
+    {
+        std::vector<AtlasJob> jobs;
+        for (int y = 0; y != julia_grid_size; ++y)
+        {
+            for (int x = 0; x != julia_grid_size; ++x)
+            {
+                Complex constant {
+                    MinMax<Real> { 0, julia_grid_size }.lerp(Real(x) + 0.5L, start_axis.cartesian_borders.x),
+                    MinMax<Real> { 0, julia_grid_size }.lerp(Real(y) + 0.5L, start_axis.cartesian_borders.y)
+                };
+                jobs.push_back(AtlasJob { thumbnailAxis({ 0, 0 }, julia_half_size), bench_iterations_count, constant });
+            }
+        }
+        return jobs;
+    }
+
+    // Centers escape slowly, so the views are not all black or all plain. Zooms are log-uniform
+    std::vector<AtlasJob> makeBookmarks(Axis const& start_axis)
+    {
+        std::mt19937 random(random_seed);
+        std::uniform_real_distribution<double> random_re(double(start_axis.cartesian_borders.x.min),
+                                                         double(start_axis.cartesian_borders.x.max));
+        std::uniform_real_distribution<double> random_im(double(start_axis.cartesian_borders.y.min),
+                                                         double(start_axis.cartesian_borders.y.max));
+        std::uniform_real_distribution<double> random_decade(min_bookmark_decade, max_bookmark_decade);
+        std::vector<AtlasJob> jobs;
+        while (jobs.size() != bookmarks_count)
+        {
+            Complex center { random_re(random), random_im(random) };
+            std::size_t escape = FractalCalcMethod::isInFractalBody(bench_iterations_count, center);
+            if (escape < min_bookmark_escape || escape == std::numeric_limits<std::size_t>::max())
+            {
+                continue;
+            }
+            Real half_size = std::pow(Real(10), Real(random_decade(random)));
+            jobs.push_back(AtlasJob { thumbnailAxis(center, half_size), bench_iterations_count, std::nullopt });
+        }
+        return jobs;
+    }
+
+    // Exact Mandelbrot and Julia escape times view by view, whatever --calc-method is, as the batch computes them
+    Atlas renderOneByOne(std::vector<AtlasJob> const& jobs)
+    {
+        CalcFractalByRowsParallel<MandelbrotFormula> mandelbrot_calc_method;
+        Atlas atlas;
+        atlas.offsets.push_back(0);
+        for (AtlasJob const& job: jobs)
+        {
+            atlas.offsets.push_back(atlas.offsets.back() + std::size_t(job.axis.screen_borders.x.max) *
+                                                           std::size_t(job.axis.screen_borders.y.max));
+        }
+        atlas.escape_times.resize(atlas.offsets.back());
+
+        for (std::size_t i = 0; i != jobs.size(); ++i)
+        {
+            AtlasJob const& job = jobs[i];
+            std::size_t offset = atlas.offsets[i];
+            auto width = std::size_t(job.axis.screen_borders.x.max);
+            auto setResult = [&atlas, offset, width](std::size_t spent_iterations, int px, int py)
+            {
+                atlas.escape_times[offset + std::size_t(py) * width + std::size_t(px)] = spent_iterations;
+            };
+            if (job.julia_constant)
+            {
+                CalcFractalByRowsParallel<JuliaFormula> julia_calc_method(JuliaFormula { *job.julia_constant });
+                julia_calc_method.calcFractal(job.iterations_count, job.axis, setResult);
+            }
+            else
+            {
+                mandelbrot_calc_method.calcFractal(job.iterations_count, job.axis, setResult);
+            }
+        }
+        return atlas;
+    }
+
+    template<class Render>
+    std::pair<Atlas, double> measureBestMs(std::string const& phase_name, Render render)
+    {
+        PerfPhase phase(phase_name);
+        Atlas atlas;
+        double best_ms = std::numeric_limits<double>::max();
+        for (int repeat = 0; repeat != bench_repeats_count; ++repeat)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            atlas = render();
+            std::chrono::duration<double, std::milli> spent = std::chrono::steady_clock::now() - begin;
+            best_ms = std::min(best_ms, spent.count());
+        }
+        return { std::move(atlas), best_ms };
+    }
+
+    void benchAtlas(std::string const& label, std::vector<AtlasJob> const& jobs, std::ostream& out)
+    {
+        auto [one_by_one, one_by_one_ms] = measureBestMs(label + " one by one", [&]
+        {
+            return renderOneByOne(jobs);
+        });
+        auto [batched, batched_ms] = measureBestMs(label + " batched", [&]
+        {
+            return AtlasRenderer().render(jobs);
+        });
+
+        std::size_t differing_count = 0;
+        for (std::size_t i = 0; i != batched.escape_times.size(); ++i)
+        {
+            differing_count += batched.escape_times[i] != one_by_one.escape_times[i];
+        }
+        auto pixels_count = double(batched.escape_times.size());
+        out << std::format("{:>10} | {:>5} | {:>15.2f} | {:>11.2f} | {:>7.2f} | {:>13.2f} | {:>11.3f}\n",
+                           label, jobs.size(), one_by_one_ms, batched_ms, one_by_one_ms / batched_ms,
+                           pixels_count / batched_ms / 1e3, 100 * double(differing_count) / pixels_count);
+    }
+}
+
+void runAtlasBenchmark(ProgramConfig const& program_config, std::ostream& out)
+{
+    out << std::format("{:>10} | {:>5} | {:>15} | {:>11} | {:>7} | {:>13} | {:>11}\n",
+                       "atlas", "views", "one by one, ms", "batched, ms", "speedup", "batched, Mpx/s", "differing %");
+    benchAtlas("julia", makeJuliaAtlas(program_config.axis), out);
+    benchAtlas("bookmarks", makeBookmarks(program_config.axis), out);
+}
@@ -0,0 +1,12 @@
+#ifndef MANDELBROT_CPP_ATLASBENCHMARK_H
+#define MANDELBROT_CPP_ATLASBENCHMARK_H
+
+#include <ostream>
+#include "../Fractal/Config.h"
+
+// Renders 64x64 thumbnails, a Julia atlas over the start view and bookmarks of random views near the boundary
+// down to long double depths, once by a row-parallel calcFractal per view and once as one AtlasRenderer batch.
+// Prints the times, the pixel throughput, the speedup and the share of pixels where double and long double differ
+void runAtlasBenchmark(ProgramConfig const& program_config, std::ostream& out);
+
+#endif //MANDELBROT_CPP_ATLASBENCHMARK_H
@@ -0,0 +1,234 @@
+#include <chrono>
+#include <format>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <gmpxx.h>
+#include "PrecisionBenchmark.h"
+#include "../Fractal/PrecisionKernels.h"
+#include "../Utility/FixedPoint.h"
+#include "../Fractal/MpnEscapeEngine.h"
+#include "../Multithreading/PerfProfiler.h"
+
+namespace
+{
+    // Misiurewicz point c = i: exactly representable and on the boundary at any depth
+    constexpr const char* center_re = "0";
+    constexpr const char* center_im = "1";
+    constexpr unsigned center_precision_bits = 512;
+    constexpr int grid_size = 64;
+    constexpr std::size_t bench_iterations_count = 2'000;
+
+    struct GridResult
+    {
+        std::vector<std::size_t> escape_times;
+        double spent_ms;
+    };
+
+    template<class Number>
+    Number numberFromMpf(mpf_class const& value)
+    {
+        if constexpr (std::is_same_v<Number, long double>)
+        {
+            char digits[128];
+            gmp_snprintf(digits, sizeof(digits), "%.40Fe", value.get_mpf_t());
+            return std::strtold(digits, nullptr);
+        }
+        else if constexpr (std::is_same_v<Number, mpf_class>)
+        {
+            return mpf_class(value, mpf_get_default_prec());
+        }
+        else
+        {
+            return Number::fromMpf(value);
+        }
+    }
+
+    template<class Number>
+    GridResult renderGrid(mpf_class const& start_re, mpf_class const& start_im, mpf_class const& step)
+    {
+        Number step_number = numberFromMpf<Number>(step);
+        Number c_im = numberFromMpf<Number>(start_im);
+        Number row_start_re = numberFromMpf<Number>(start_re);
+
+        GridResult result;
+        result.escape_times.reserve(grid_size * grid_size);
+        auto begin = std::chrono::steady_clock::now();
+        for (int y = 0; y != grid_size; ++y)
+        {
+            Number c_re = row_start_re;
+            for (int x = 0; x != grid_size; ++x)
+            {
+                result.escape_times.push_back(escapeTime(bench_iterations_count, c_re, c_im));
+                c_re = c_re + step_number;
+            }
+            c_im = c_im + step_number;
+        }
+        result.spent_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        return result;
+    }
+
+    GridResult renderGridMpn(mpf_class const& start_re, mpf_class const& start_im, mpf_class const& step)
+    {
+        MpnEscapeEngine engine;
+        std::size_t limbs_count = MpnEscapeEngine::limbsForPixelSize(step);
+        engine.setLimbsCount(limbs_count);
+        MpnFixed step_fixed = MpnFixed::fromMpf(step, limbs_count);
+        MpnFixed c_im = MpnFixed::fromMpf(start_im, limbs_count);
+        MpnFixed row_start_re = MpnFixed::fromMpf(start_re, limbs_count);
+
+        GridResult result;
+        result.escape_times.reserve(grid_size * grid_size);
+        auto begin = std::chrono::steady_clock::now();
+        for (int y = 0; y != grid_size; ++y)
+        {
+            MpnFixed c_re = row_start_re;
+            for (int x = 0; x != grid_size; ++x)
+            {
+                result.escape_times.push_back(engine.escapeTime(bench_iterations_count, c_re, c_im));
+                engine.addInPlace(c_re, step_fixed);
+            }
+            engine.addInPlace(c_im, step_fixed);
+        }
+        result.spent_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        return result;
+    }
+
+    struct OrbitResult
+    {
+        std::vector<Complex> orbit;
+        double spent_ms;
+    };
+
+    // The reference orbit the way an mpf_class implementation computes it, at the default precision
+    OrbitResult mpfOrbit(mpf_class const& c_re, mpf_class const& c_im)
+    {
+        mpf_class z_re = 0, z_im = 0, z_re_square = 0, z_im_square = 0;
+        std::vector<std::pair<mpf_class, mpf_class>> points;
+        points.reserve(bench_iterations_count);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i != bench_iterations_count; ++i)
+        {
+            z_im = 2 * z_re * z_im + c_im;
+            z_re = z_re_square - z_im_square + c_re;
+            z_re_square = z_re * z_re;
+            z_im_square = z_im * z_im;
+            points.emplace_back(z_re, z_im);
+            if (z_re_square + z_im_square > 4)
+            {
+                break;
+            }
+        }
+        OrbitResult result { { }, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() };
+
+        result.orbit.reserve(points.size());
+        for (auto const& [re, im]: points)
+        {
+            result.orbit.push_back(Complex { numberFromMpf<long double>(re), numberFromMpf<long double>(im) });
+        }
+        return result;
+    }
+
+    // The largest |z - z_truth| over the iterations both orbits reached
+    long double maxDeviation(std::vector<Complex> const& orbit, std::vector<Complex> const& truth)
+    {
+        long double deviation = 0;
+        for (std::size_t i = 0; i != std::min(orbit.size(), truth.size()); ++i)
+        {
+            deviation = std::max(deviation, std::hypot(orbit[i].re - truth[i].re, orbit[i].im - truth[i].im));
+        }
+        return deviation;
+    }
+
+    double mismatchPercent(GridResult const& result, GridResult const& reference)
+    {
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i != reference.escape_times.size(); ++i)
+        {
+            mismatches += result.escape_times[i] != reference.escape_times[i];
+        }
+        return 100.0 * double(mismatches) / double(reference.escape_times.size());
+    }
+}
+
+void runPrecisionBenchmark(std::ostream& out)
+{
+    out << std::format("{:>6} | {:>18} | {:>18} | {:>18} | {:>18} | {:>18} | {:>18}\n",
+                       "depth", "long double", "fixed128", "fixed192", "fixed256", "gmp mpf", "gmp mpn");
+    out << std::format("{:>6} | {:>18} | {:>18} | {:>18} | {:>18} | {:>18} | {:>18}\n",
+                       "", "ms / differ", "ms / differ", "ms / differ", "ms / differ", "ms / differ", "ms / differ");
+
+    for (int depth_exponent = 5; depth_exponent <= 35; depth_exponent += 5)
+    {
+        mpf_set_default_prec(center_precision_bits);
+        mpf_class depth = 1;
+        for (int i = 0; i != depth_exponent; ++i)
+        {
+            depth /= 10;
+        }
+        mpf_class step = depth / grid_size;
+        mpf_class start_re = mpf_class(center_re) - depth / 2;
+        mpf_class start_im = mpf_class(center_im) - depth / 2;
+
+        // The kernels run on this thread, so it's measured as a whole for the hardware counters
+        auto profiled = [depth_exponent](const char* kernel, auto render)
+        {
+            PerfPhase phase(std::format("1e-{} {}", depth_exponent, kernel), true);
+            return render();
+        };
+        GridResult fixed256 = profiled("fixed256", [&] { return renderGrid<Fixed256>(start_re, start_im, step); });
+        GridResult fixed192 = profiled("fixed192", [&] { return renderGrid<Fixed192>(start_re, start_im, step); });
+        GridResult fixed128 = profiled("fixed128", [&] { return renderGrid<Fixed128>(start_re, start_im, step); });
+        GridResult long_double = profiled("long double", [&] { return renderGrid<long double>(start_re, start_im, step); });
+
+        // The precision GMP would be given for this depth: the pixel step plus a guard word
+        mpf_set_default_prec(mp_bitcnt_t(std::ceil(depth_exponent * std::log2(10.0))) + 5 + 64);
+        GridResult gmp = profiled("gmp mpf", [&] { return renderGrid<mpf_class>(start_re, start_im, step); });
+        mpf_set_default_prec(center_precision_bits);
+        GridResult mpn = profiled("gmp mpn", [&] { return renderGridMpn(start_re, start_im, step); });
+
+        auto cell = [&fixed256](GridResult const& result)
+        {
+            return std::format("{:>9.1f} / {:>4.1f}%", result.spent_ms, mismatchPercent(result, fixed256));
+        };
+        out << std::format("{:>6} | {} | {} | {} | {} | {} | {}\n", std::format("1e-{}", depth_exponent),
+                           cell(long_double), cell(fixed128), cell(fixed192), cell(fixed256), cell(gmp), cell(mpn));
+    }
+
+    // The reference orbit of a point off the center, which neither precision represents exactly.
+    // One engine for all the depths, as a render thread keeps one, so its orbit buffer is reused
+    out << std::format("\n{:>6} | {:>6} | {:>9} | {:>9} | {:>15} | {:>12} | {:>12}\n",
+                       "depth", "limbs", "mpn ms", "mpf ms", "length mpn/mpf", "mpn |dz|", "mpf |dz|");
+    MpnEscapeEngine engine;
+    for (int depth_exponent = 5; depth_exponent <= 35; depth_exponent += 5)
+    {
+        mpf_set_default_prec(center_precision_bits);
+        mpf_class depth = 1;
+        for (int i = 0; i != depth_exponent; ++i)
+        {
+            depth /= 10;
+        }
+        mpf_class c_re = mpf_class(center_re) + depth * mpf_class("0.3");
+        mpf_class c_im = mpf_class(center_im) + depth * mpf_class("0.2");
+        std::vector<Complex> truth = mpfOrbit(c_re, c_im).orbit;
+
+        std::size_t limbs_count = MpnEscapeEngine::limbsForPixelSize(depth / grid_size);
+        MpnFixed c_re_fixed = MpnFixed::fromMpf(c_re, limbs_count);
+        MpnFixed c_im_fixed = MpnFixed::fromMpf(c_im, limbs_count);
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<Complex> const& mpn_orbit = engine.referenceOrbit(c_re_fixed, c_im_fixed, bench_iterations_count);
+        double mpn_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        // mpf_class at the same number of limbs
+        mpf_set_default_prec(mp_bitcnt_t(GMP_NUMB_BITS) * limbs_count);
+        OrbitResult mpf = mpfOrbit(mpf_class(c_re), mpf_class(c_im));
+
+        out << std::format("{:>6} | {:>6} | {:>9.3f} | {:>9.3f} | {:>15} | {:>12.3e} | {:>12.3e}{}\n",
+                           std::format("1e-{}", depth_exponent), limbs_count, mpn_ms, mpf.spent_ms,
+                           std::format("{}/{}", mpn_orbit.size(), mpf.orbit.size()),
+                           maxDeviation(mpn_orbit, truth), maxDeviation(mpf.orbit, truth),
+                           mpn_orbit.size() == truth.size() ? "" : std::format("  length differs from {}", truth.size()));
+    }
+    mpf_set_default_prec(center_precision_bits);
+}
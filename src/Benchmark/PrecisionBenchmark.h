@@ -0,0 +1,12 @@
+#ifndef MANDELBROT_CPP_PRECISIONBENCHMARK_H
+#define MANDELBROT_CPP_PRECISIONBENCHMARK_H
+
+#include <ostream>
+
+// Renders a small grid around a boundary point at zoom depths down to 1e-35 with long double,
+// 128/192/256-bit fixed point, GMP mpf_class and MpnEscapeEngine. Prints the time and the share of pixels that
+// differ from the 256-bit result. Then computes MpnEscapeEngine::referenceOrbit near the same point and prints
+// its time and deviation from a 512-bit mpf_class orbit, next to an mpf_class orbit of the same precision
+void runPrecisionBenchmark(std::ostream& out);
+
+#endif //MANDELBROT_CPP_PRECISIONBENCHMARK_H
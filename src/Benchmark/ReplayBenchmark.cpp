@@ -0,0 +1,79 @@
+#include <format>
+#include <map>
+#include "ReplayBenchmark.h"
+#include "../Fractal/MandelbrotFractal.h"
+#include "../Utility/InteractionLog.h"
+#include "../Multithreading/PerfProfiler.h"
+
+namespace
+{
+    struct Latencies
+    {
+        std::vector<double> first_result_ms;
+        std::vector<double> final_image_ms;
+    };
+
+    void printLatencies(std::string const& action, Latencies const& latencies, std::ostream& out)
+    {
+        auto const& first = latencies.first_result_ms;
+        auto const& last = latencies.final_image_ms;
+        out << std::format("{:>16} | {:>5} | {:>7.2f} {:>7.2f} {:>7.2f} | {:>7.2f} {:>7.2f} {:>7.2f}\n",
+                           action, first.size(),
+                           percentile(first, 50), percentile(first, 95), percentile(first, 99),
+                           percentile(last, 50), percentile(last, 95), percentile(last, 99));
+    }
+}
+
+void runReplayBenchmark(ProgramConfig const& program_config, std::string const& log_path, std::ostream& out)
+{
+    std::vector<InteractionRecord> records = loadInteractions(log_path);
+    if (records.empty())
+    {
+        out << "No interactions in " << log_path << '\n';
+        return;
+    }
+
+    MandelbrotFractal fractal(program_config);
+
+    // Warms the pool, the color table and the image pages up
+    fractal.calculate(program_config.axis);
+
+    std::map<std::string, Latencies> latencies_by_action;
+    Latencies all_latencies;
+    std::map<std::string, double> pixels_shares_sums;
+    for (InteractionRecord const& record: records)
+    {
+        Axis axis { record.cartesian_borders, program_config.axis.screen_borders };
+        fractal.setIterationsCount(record.iterations_count);
+        {
+            PerfPhase phase(record.action);
+            fractal.calculate(axis);
+        }
+
+        MandelbrotFractal::FrameTiming timing = fractal.lastFrameTiming();
+        for (Latencies* latencies: { &latencies_by_action[record.action], &all_latencies })
+        {
+            latencies->first_result_ms.push_back(timing.first_result.count());
+            latencies->final_image_ms.push_back(timing.final_image.count());
+        }
+        for (FractalCalcMethod::PixelsShare const& share: program_config.calc_method->lastFramePixelsShares())
+        {
+            pixels_shares_sums[share.label] += share.fraction;
+        }
+    }
+
+    out << std::format("{:>16} | {:>5} | {:^23} | {:^23}\n", "", "", "first pixel, ms", "final image, ms");
+    out << std::format("{:>16} | {:>5} | {:>7} {:>7} {:>7} | {:>7} {:>7} {:>7}\n",
+                       "interaction", "count", "p50", "p95", "p99", "p50", "p95", "p99");
+    for (auto const& [action, latencies]: latencies_by_action)
+    {
+        printLatencies(action, latencies, out);
+    }
+    printLatencies("all", all_latencies, out);
+
+    // Averaged over all the frames
+    for (auto const& [label, fractions_sum]: pixels_shares_sums)
+    {
+        out << std::format("Pixels {}: {:.1f}%\n", label, fractions_sum / double(records.size()) * 100);
+    }
+}
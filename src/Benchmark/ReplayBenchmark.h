@@ -0,0 +1,12 @@
+#ifndef MANDELBROT_CPP_REPLAYBENCHMARK_H
+#define MANDELBROT_CPP_REPLAYBENCHMARK_H
+
+#include <ostream>
+#include <string>
+#include "../Fractal/Config.h"
+
+// Renders every view of a recorded interaction log headlessly, one frame per interaction,
+// and prints p50/p95/p99 of the time to the first pixel and to the final image per interaction kind
+void runReplayBenchmark(ProgramConfig const& program_config, std::string const& log_path, std::ostream& out);
+
+#endif //MANDELBROT_CPP_REPLAYBENCHMARK_H
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <format>
+#include <iostream>
+#include "ScalingBenchmark.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+#include "../Multithreading/PerfProfiler.h"
+
+namespace
+{
+    constexpr std::size_t bench_iterations_count = 500;
+    constexpr int bench_frames_count = 5;
+
+    double measureFrameMs(ProgramConfig const& program_config)
+    {
+        Axis const& axis = program_config.axis;
+        std::size_t pixels_count = std::size_t(axis.screen_borders.x.max) * std::size_t(axis.screen_borders.y.max);
+
+        // Not initialized, so the pages are first touched by the workers
+        std::unique_ptr<std::size_t[]> iterations_map(new std::size_t[pixels_count]);
+        auto setResult = [&iterations_map, &axis](std::size_t spent_iterations, int px, int py)
+        {
+            iterations_map[std::size_t(py) * std::size_t(axis.screen_borders.x.max) + std::size_t(px)] = spent_iterations;
+        };
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int frame = 0; frame != bench_frames_count; ++frame)
+        {
+            program_config.calc_method->calcFractal(bench_iterations_count, axis, setResult);
+        }
+        std::chrono::duration<double, std::milli> spent = std::chrono::steady_clock::now() - begin;
+        return spent.count() / bench_frames_count;
+    }
+
+    std::vector<std::size_t> threadCountsUpTo(std::size_t max_threads)
+    {
+        std::vector<std::size_t> counts;
+        for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+        {
+            counts.push_back(threads);
+        }
+        counts.push_back(max_threads);
+        return counts;
+    }
+
+    void benchCpuSet(ProgramConfig const& program_config, std::string const& label, std::vector<int> const& cpus,
+                     std::ostream& out)
+    {
+        double single_thread_ms = 0;
+        for (std::size_t threads: threadCountsUpTo(cpus.size()))
+        {
+            // The main thread takes the first CPU, the workers take the rest. One thread is the main thread alone
+            std::vector<int> worker_cpus(cpus.begin() + 1, cpus.begin() + std::ptrdiff_t(threads));
+            ThreadPoolSimpleInstance::configure(ThreadPoolConfig { threads - 1, worker_cpus, { cpus.front() } });
+
+            PerfPhase phase(std::format("{} x{}", label, threads));
+            double frame_ms = measureFrameMs(program_config);
+            if (threads == 1)
+            {
+                single_thread_ms = frame_ms;
+            }
+            out << std::format("{:>8} | {:>7} | {:>10.2f} | {:>7.2f}\n",
+                               label, threads, frame_ms, single_thread_ms / frame_ms);
+        }
+    }
+}
+
+void runScalingBenchmark(ProgramConfig const& program_config, std::ostream& out)
+{
+    CpuTopology topology = CpuTopology::detect();
+    out << std::format("{:>8} | {:>7} | {:>10} | {:>7}\n", "cpus", "threads", "frame, ms", "speedup");
+
+    for (std::size_t node = 0; node != topology.node_cpus.size(); ++node)
+    {
+        benchCpuSet(program_config, "node " + std::to_string(node), topology.node_cpus[node], out);
+    }
+    if (topology.node_cpus.size() > 1)
+    {
+        benchCpuSet(program_config, "all", topology.allCpus(), out);
+    }
+
+    if (!pinCurrentThreadToCpus(topology.allCpus()))
+    {
+        std::clog << "Can't unpin the main thread from the benchmarked CPUs\n";
+    }
+    ThreadPoolSimpleInstance::configure(program_config.thread_pool_config);
+}
@@ -0,0 +1,11 @@
+#ifndef MANDELBROT_CPP_SCALINGBENCHMARK_H
+#define MANDELBROT_CPP_SCALINGBENCHMARK_H
+
+#include <ostream>
+#include "../Fractal/Config.h"
+
+// Renders the start view headlessly with a growing number of threads pinned to one NUMA node
+// (and then to all of them) and prints the frame time and the speedup over a single thread
+void runScalingBenchmark(ProgramConfig const& program_config, std::ostream& out);
+
+#endif //MANDELBROT_CPP_SCALINGBENCHMARK_H
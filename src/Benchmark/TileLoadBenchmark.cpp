@@ -0,0 +1,146 @@
+#include <SFML/Network.hpp>
+#include <chrono>
+#include <format>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "TileLoadBenchmark.h"
+#include "../Server/TileServer.h"
+#include "../Utility/Functions.h"
+
+namespace
+{
+    const sf::Time server_probe_timeout = sf::milliseconds(500);
+
+    struct Response
+    {
+        bool is_ok = false;
+        std::string source;
+        double spent_ms = 0;
+    };
+
+    Response requestTile(unsigned short port, int z, long long x, long long y)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        Response response;
+        sf::TcpSocket socket;
+        if (socket.connect(sf::IpAddress::LocalHost, port) != sf::Socket::Done)
+        {
+            return response;
+        }
+
+        std::string request = std::format("GET /{}/{}/{}.png HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n",
+                                          z, x, y);
+        if (socket.send(request.data(), request.size()) != sf::Socket::Done)
+        {
+            return response;
+        }
+
+        std::string answer;
+        char buffer[16 * 1024];
+        std::size_t received = 0;
+        while (socket.receive(buffer, sizeof(buffer), received) == sf::Socket::Done)
+        {
+            answer.append(buffer, received);
+        }
+        response.spent_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        response.is_ok = answer.starts_with("HTTP/1.1 200");
+        constexpr std::string_view source_header = "X-Tile-Source: ";
+        if (auto source_pos = answer.find(source_header); source_pos != std::string::npos)
+        {
+            source_pos += source_header.size();
+            response.source = answer.substr(source_pos, answer.find("\r\n", source_pos) - source_pos);
+        }
+        return response;
+    }
+
+    void printLatencies(std::string const& label, std::vector<double> const& latencies_ms, std::ostream& out)
+    {
+        if (latencies_ms.empty())
+        {
+            return;
+        }
+        out << std::format("{:>10} | {:>6} | {:>8.2f} {:>8.2f} {:>8.2f}\n", label, latencies_ms.size(),
+                           percentile(latencies_ms, 50), percentile(latencies_ms, 95), percentile(latencies_ms, 99));
+    }
+}
+
+void runTileLoadBenchmark(ProgramConfig const& program_config, std::ostream& out)
+{
+    TileServerConfig const& config = program_config.tile_server_config;
+
+    // Stopped once the clients are done
+    std::unique_ptr<TileServer> in_process_server;
+    std::thread in_process_server_thread;
+    sf::TcpSocket probe;
+    if (probe.connect(sf::IpAddress::LocalHost, config.port, server_probe_timeout) != sf::Socket::Done)
+    {
+        in_process_server = std::make_unique<TileServer>(program_config);
+        in_process_server->listen();
+        in_process_server_thread = std::thread(&TileServer::run, in_process_server.get());
+        out << std::format("No tile server on the port {}, started an in-process one\n", config.port);
+    }
+    probe.disconnect();
+
+    std::mutex responses_mutex;
+    std::vector<Response> responses;
+
+    auto client = [&](std::size_t client_index)
+    {
+        std::mt19937 random { unsigned(client_index) };
+        std::uniform_int_distribution<int> random_zoom(0, config.load_max_zoom);
+        std::vector<Response> client_responses;
+        for (std::size_t i = 0; i != config.load_requests_per_client; ++i)
+        {
+            int z = random_zoom(random);
+            std::uniform_int_distribution<long long> random_tile(0, (1LL << z) - 1);
+            long long x = random_tile(random);
+            client_responses.push_back(requestTile(config.port, z, x, random_tile(random)));
+        }
+
+        std::lock_guard lock(responses_mutex);
+        responses.insert(responses.end(), client_responses.begin(), client_responses.end());
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (std::size_t i = 0; i != config.load_clients_count; ++i)
+    {
+        clients.emplace_back(client, i);
+    }
+    for (std::thread& client_thread: clients)
+    {
+        client_thread.join();
+    }
+    std::chrono::duration<double> spent = std::chrono::steady_clock::now() - begin;
+    if (in_process_server)
+    {
+        in_process_server->stop();
+        in_process_server_thread.join();
+    }
+
+    std::map<std::string, std::vector<double>> latencies_by_source;
+    std::vector<double> all_latencies;
+    std::size_t failed_count = 0;
+    for (Response const& response: responses)
+    {
+        if (!response.is_ok)
+        {
+            ++failed_count;
+            continue;
+        }
+        latencies_by_source[response.source].push_back(response.spent_ms);
+        all_latencies.push_back(response.spent_ms);
+    }
+
+    out << std::format("{} clients, {} tiles in {:.2f} s: {:.1f} tiles/s, {} failed\n", config.load_clients_count,
+                       all_latencies.size(), spent.count(), double(all_latencies.size()) / spent.count(), failed_count);
+    out << std::format("{:>10} | {:>6} | {:>8} {:>8} {:>8}\n", "source", "tiles", "p50, ms", "p95, ms", "p99, ms");
+    for (auto const& [source, latencies_ms]: latencies_by_source)
+    {
+        printLatencies(source, latencies_ms, out);
+    }
+    printLatencies("all", all_latencies, out);
+}
@@ -0,0 +1,11 @@
+#ifndef MANDELBROT_CPP_TILELOADBENCHMARK_H
+#define MANDELBROT_CPP_TILELOADBENCHMARK_H
+
+#include <ostream>
+#include "../Fractal/Config.h"
+
+// Concurrent clients request random tiles from the tile server on localhost, an in-process one when none listens.
+// Prints the tiles per second and p50/p95/p99 of the response time by the tile source (cache, coalesced, render)
+void runTileLoadBenchmark(ProgramConfig const& program_config, std::ostream& out);
+
+#endif //MANDELBROT_CPP_TILELOADBENCHMARK_H
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <limits>
+#include "AtlasRenderer.h"
+#include "TaskIterators.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+
+namespace
+{
+    std::size_t viewPixels(Axis const& axis)
+    {
+        return std::size_t(std::max(axis.screen_borders.x.max, 0)) * std::size_t(std::max(axis.screen_borders.y.max, 0));
+    }
+
+    bool isDoubleEnough(Axis const& axis, Real min_pixel_ratio)
+    {
+        PlaneBorders<Real> const& borders = axis.cartesian_borders;
+        Real pixel_size = std::min(std::abs(borders.x.max - borders.x.min) / Real(axis.screen_borders.x.max),
+                                   std::abs(borders.y.max - borders.y.min) / Real(axis.screen_borders.y.max));
+        Real magnitude = std::max({ std::abs(borders.x.min), std::abs(borders.x.max),
+                                    std::abs(borders.y.min), std::abs(borders.y.max), Real(1) });
+        return pixel_size >= magnitude * min_pixel_ratio;
+    }
+}
+
+Atlas AtlasRenderer::render(std::vector<AtlasJob> const& jobs) const
+{
+    Atlas atlas;
+    atlas.offsets.reserve(jobs.size() + 1);
+    atlas.offsets.push_back(0);
+    std::vector<bool> is_double_job;
+    is_double_job.reserve(jobs.size());
+    for (AtlasJob const& job: jobs)
+    {
+        atlas.offsets.push_back(atlas.offsets.back() + viewPixels(job.axis));
+        is_double_job.push_back(isDoubleEnough(job.axis, min_double_pixel_ratio));
+    }
+
+    std::size_t pixels_count = atlas.offsets.back();
+    if (pixels_count == 0)
+    {
+        return atlas;
+    }
+    atlas.escape_times.resize(pixels_count);
+
+    auto units_count = int((pixels_count + unit_pixels - 1) / unit_pixels);
+    auto unit_task = [this, &jobs, &is_double_job, &atlas, pixels_count](int unit)
+    {
+        std::size_t begin = std::size_t(unit) * unit_pixels;
+        renderUnit(jobs, is_double_job, atlas, begin, std::min(begin + unit_pixels, pixels_count));
+    };
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto units_latch = thread_pool.addTasks(RowTasksIterator<decltype(unit_task)> { unit_task, units_count });
+    thread_pool.joinMainToWorkers(*units_latch);
+    return atlas;
+}
+
+void AtlasRenderer::renderUnit(std::vector<AtlasJob> const& jobs, std::vector<bool> const& is_double_job, Atlas& atlas,
+                               std::size_t begin, std::size_t end) const
+{
+    auto first_job = std::upper_bound(atlas.offsets.begin(), atlas.offsets.end(), begin) - atlas.offsets.begin() - 1;
+    auto job = std::size_t(first_job);
+    std::size_t next_pixel = begin;
+
+    // Structure of arrays, so the iteration of all the lanes is one loop over each array
+    alignas(64) double z_re[lanes_count] { };
+    alignas(64) double z_im[lanes_count] { };
+    alignas(64) double c_re[lanes_count] { };
+    alignas(64) double c_im[lanes_count] { };
+    alignas(64) double steps[lanes_count] { };
+    alignas(64) double escapes[lanes_count] { };
+    alignas(64) double limits[lanes_count] { };
+    std::size_t pixels[lanes_count] { };
+    bool is_busy[lanes_count] { };
+    std::size_t busy_count = 0;
+
+    // The next pixel of the unit that takes double. Pixels of long double views on the way are computed right away
+    auto loadLane = [&](std::size_t lane)
+    {
+        for (; next_pixel != end; ++next_pixel)
+        {
+            while (next_pixel >= atlas.offsets[job + 1])
+            {
+                ++job;
+            }
+            AtlasJob const& view = jobs[job];
+            auto index = int(next_pixel - atlas.offsets[job]);
+            int width = view.axis.screen_borders.x.max;
+            Complex point { view.axis.screenToCartesianX(index % width), view.axis.screenToCartesianY(index / width) };
+
+            if (!is_double_job[job])
+            {
+                atlas.escape_times[next_pixel] = view.julia_constant
+                    ? FractalCalcMethod::isInFractalBody(view.iterations_count, point, JuliaFormula { *view.julia_constant })
+                    : FractalCalcMethod::isInFractalBody(view.iterations_count, point);
+                continue;
+            }
+
+            Complex z = view.julia_constant ? point : Complex { 0, 0 };
+            Complex c = view.julia_constant ? *view.julia_constant : point;
+            z_re[lane] = double(z.re);
+            z_im[lane] = double(z.im);
+            c_re[lane] = double(c.re);
+            c_im[lane] = double(c.im);
+            steps[lane] = 0;
+            escapes[lane] = std::numeric_limits<double>::infinity();
+            limits[lane] = double(view.iterations_count);
+            pixels[lane] = next_pixel++;
+            is_busy[lane] = true;
+            return;
+        }
+
+        // Idle lanes keep iterating the fixed point 0
+        z_re[lane] = z_im[lane] = c_re[lane] = c_im[lane] = 0;
+        is_busy[lane] = false;
+    };
+
+    for (std::size_t lane = 0; lane != lanes_count; ++lane)
+    {
+        loadLane(lane);
+        busy_count += is_busy[lane];
+    }
+
+    while (busy_count != 0)
+    {
+        for (int step = 0; step != steps_per_check; ++step)
+        {
+            for (std::size_t lane = 0; lane != lanes_count; ++lane)
+            {
+                double re = z_re[lane];
+                double im = z_im[lane];
+                z_re[lane] = re * re - im * im + c_re[lane];
+                z_im[lane] = 2 * re * im + c_im[lane];
+
+                // An escaped orbit runs to infinity and NaN, its first escape is kept
+                double norm = z_re[lane] * z_re[lane] + z_im[lane] * z_im[lane];
+                escapes[lane] = norm > 4 ? std::min(escapes[lane], steps[lane]) : escapes[lane];
+                steps[lane] += 1;
+            }
+        }
+
+        for (std::size_t lane = 0; lane != lanes_count; ++lane)
+        {
+            bool is_escaped = escapes[lane] < limits[lane];
+            if (!is_busy[lane] || (!is_escaped && steps[lane] < limits[lane]))
+            {
+                continue;
+            }
+            atlas.escape_times[pixels[lane]] = is_escaped
+                ? std::size_t(escapes[lane])
+                : std::numeric_limits<std::size_t>::max();
+            loadLane(lane);
+            busy_count -= !is_busy[lane];
+        }
+    }
+}
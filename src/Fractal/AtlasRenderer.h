@@ -0,0 +1,49 @@
+#ifndef MANDELBROT_CPP_ATLASRENDERER_H
+#define MANDELBROT_CPP_ATLASRENDERER_H
+
+#include <optional>
+#include <vector>
+#include "FractalCalcMethods.h"
+
+// One view of an atlas: the Mandelbrot set, or the Julia set of julia_constant
+struct AtlasJob
+{
+    Axis axis;
+    std::size_t iterations_count;
+    std::optional<Complex> julia_constant;
+};
+
+// Escape times of all the views of a batch, view after view, each one row by row
+struct Atlas
+{
+    std::vector<std::size_t> escape_times;
+
+    // First pixel of every view in escape_times, and the end of the last one
+    std::vector<std::size_t> offsets;
+};
+
+// Renders many small views in one submission to the thread pool instead of a calcFractal per view.
+// The pixels of all the views are cut into work units of unit_pixels, a unit may span several views.
+// A unit iterates lanes_count pixels side by side on doubles, a lane takes the next pixel once its own one is done.
+// Pixels too small for double are computed on long double as isInFractalBody does
+class AtlasRenderer
+{
+public:
+    [[nodiscard]] Atlas render(std::vector<AtlasJob> const& jobs) const;
+
+private:
+    void renderUnit(std::vector<AtlasJob> const& jobs, std::vector<bool> const& is_double_job, Atlas& atlas,
+                    std::size_t begin, std::size_t end) const;
+
+private:
+    static constexpr std::size_t unit_pixels = 2048;
+    static constexpr std::size_t lanes_count = 8;
+
+    // Lanes are refilled every steps_per_check iterations, a finished pixel idles at most that long
+    static constexpr int steps_per_check = 16;
+
+    // Pixel size relative to the coordinates under which the view is computed on long double
+    static constexpr Real min_double_pixel_ratio = 0x1p-40L;
+};
+
+#endif //MANDELBROT_CPP_ATLASRENDERER_H
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include "AutoTuner.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+
+namespace
+{
+    // Seahorse valley: boundary, interior and fast escaping pixels together
+    constexpr Complex shallow_center = { -0.7436L, 0.1318L };
+    constexpr Real shallow_pixel_size = 5e-5L;
+    constexpr int shallow_width = 384;
+    constexpr int shallow_height = 288;
+    constexpr std::size_t shallow_iterations_count = 300;
+    constexpr int rows_per_task_candidates[] = { 1, 2, 4, 8, 16 };
+    constexpr std::string_view shallow_calc_method_candidates[] = { "rows", "balanced", "pixels" };
+
+    // Misiurewicz point c = i stays on the boundary at any depth
+    constexpr Complex deep_center = { 0, 1 };
+    constexpr int deep_width = 64;
+    constexpr int deep_height = 48;
+    constexpr std::size_t deep_iterations_count = 1'000;
+    constexpr std::string_view deep_calc_method_candidates[] = { "fixed128", "fixed192", "fixed256", "mpn" };
+    constexpr double max_mismatch_fraction = 0.01;
+
+    constexpr int measure_runs = 2;
+
+    struct Measurement
+    {
+        double best_ms = std::numeric_limits<double>::max();
+        std::vector<std::size_t> escape_times;
+    };
+
+    Axis viewAround(Complex center, Real pixel_size, int width, int height)
+    {
+        Real half_width = pixel_size * width / 2;
+        Real half_height = pixel_size * height / 2;
+        return Axis { PlaneBorders<Real> { MinMax<Real> { center.re - half_width, center.re + half_width },
+                                           MinMax<Real> { center.im - half_height, center.im + half_height }},
+                      PlaneBorders<int> { MinMax<int> { 0, width }, MinMax<int> { 0, height }}};
+    }
+
+    Measurement measure(FractalCalcMethod& calc_method, Axis const& axis, std::size_t iterations_count)
+    {
+        int width = axis.screen_borders.x.max;
+        Measurement measurement;
+        measurement.escape_times.resize(std::size_t(width) * std::size_t(axis.screen_borders.y.max));
+        auto setResult = [&measurement, width](std::size_t spent_iterations, int px, int py)
+        {
+            measurement.escape_times[std::size_t(py) * std::size_t(width) + std::size_t(px)] = spent_iterations;
+        };
+
+        for (int run = 0; run != measure_runs; ++run)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            calc_method.calcFractal(iterations_count, axis, setResult);
+            std::chrono::duration<double, std::milli> spent = std::chrono::steady_clock::now() - begin;
+            measurement.best_ms = std::min(measurement.best_ms, spent.count());
+        }
+        return measurement;
+    }
+
+    double mismatchFraction(std::vector<std::size_t> const& escape_times, std::vector<std::size_t> const& reference)
+    {
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i != reference.size(); ++i)
+        {
+            mismatches += escape_times[i] != reference[i];
+        }
+        return double(mismatches) / double(reference.size());
+    }
+
+    void tuneShallowTier(TuningProfile& profile, std::ostream& log)
+    {
+        Axis axis = viewAround(shallow_center, shallow_pixel_size, shallow_width, shallow_height);
+        double best_ms = std::numeric_limits<double>::max();
+        for (int rows_per_task: rows_per_task_candidates)
+        {
+            CalcFractalByRowsParallel<> calc_method(MandelbrotFormula { }, rows_per_task);
+            double spent_ms = measure(calc_method, axis, shallow_iterations_count).best_ms;
+            log << std::format("Auto-tune: rows by {:<2} {:>8.2f} ms\n", rows_per_task, spent_ms);
+            if (spent_ms < best_ms)
+            {
+                best_ms = spent_ms;
+                profile.calc_method = "rows";
+                profile.rows_per_task = rows_per_task;
+            }
+        }
+
+        // The second run of the balanced method is scheduled by the costs of the first one, as in a session
+        double balanced_ms = measure(*makeCalcMethodByName("balanced"), axis, shallow_iterations_count).best_ms;
+        log << std::format("Auto-tune: balanced   {:>8.2f} ms\n", balanced_ms);
+        if (balanced_ms < best_ms)
+        {
+            best_ms = balanced_ms;
+            profile.calc_method = "balanced";
+        }
+
+        double pixels_ms = measure(*makeCalcMethodByName("pixels"), axis, shallow_iterations_count).best_ms;
+        log << std::format("Auto-tune: pixels     {:>8.2f} ms\n", pixels_ms);
+        if (pixels_ms < best_ms)
+        {
+            profile.calc_method = "pixels";
+        }
+    }
+
+    // The first depth where the shallow tier differs from 256-bit fixed point, the deepest tested one otherwise
+    Real findFirstImpreciseDepth(TuningProfile& profile, FractalCalcMethod& shallow_calc_method, std::ostream& log)
+    {
+        CalcFractalFixedPoint<4> reference_calc_method;
+        profile.deep_pixel_size = 1e-11L;
+        for (Real pixel_size = 1e-12L; pixel_size > 1e-20L; pixel_size /= 10)
+        {
+            Axis axis = viewAround(deep_center, pixel_size, deep_width, deep_height);
+            double mismatch = mismatchFraction(measure(shallow_calc_method, axis, deep_iterations_count).escape_times,
+                                               measure(reference_calc_method, axis, deep_iterations_count).escape_times);
+            log << std::format("Auto-tune: pixel {:.0e} differs by {:.1f}%\n", double(pixel_size), mismatch * 100);
+            if (mismatch > max_mismatch_fraction)
+            {
+                return pixel_size;
+            }
+            profile.deep_pixel_size = pixel_size;
+        }
+        return profile.deep_pixel_size;
+    }
+
+    void tuneDeepTier(TuningProfile& profile, Real pixel_size, std::ostream& log)
+    {
+        Axis axis = viewAround(deep_center, pixel_size, deep_width, deep_height);
+        Measurement reference = measure(*makeCalcMethodByName("fixed256"), axis, deep_iterations_count);
+
+        double best_ms = std::numeric_limits<double>::max();
+        for (std::string_view method_name: deep_calc_method_candidates)
+        {
+            Measurement measurement = measure(*makeCalcMethodByName(method_name), axis, deep_iterations_count);
+            bool is_precise = mismatchFraction(measurement.escape_times, reference.escape_times) <= max_mismatch_fraction;
+            log << std::format("Auto-tune: {:<10} {:>8.2f} ms{}\n", method_name, measurement.best_ms,
+                               is_precise ? "" : " (imprecise)");
+            if (is_precise && measurement.best_ms < best_ms)
+            {
+                best_ms = measurement.best_ms;
+                profile.deep_calc_method = method_name;
+            }
+        }
+    }
+}
+
+std::optional<TuningProfile> TuningProfile::load(std::string const& file_path, std::size_t threads_count)
+{
+    std::ifstream file { file_path };
+    TuningProfile profile;
+    std::string key;
+    std::string value;
+    try
+    {
+        while (file >> key >> value)
+        {
+            if (key == "threads_count")
+            {
+                profile.threads_count = std::stoul(value);
+            }
+            else if (key == "calc_method")
+            {
+                profile.calc_method = value;
+            }
+            else if (key == "rows_per_task")
+            {
+                profile.rows_per_task = std::stoi(value);
+            }
+            else if (key == "deep_calc_method")
+            {
+                profile.deep_calc_method = value;
+            }
+            else if (key == "deep_pixel_size")
+            {
+                profile.deep_pixel_size = std::stold(value);
+            }
+        }
+    } catch (std::exception const&)
+    {
+        return std::nullopt;
+    }
+
+    // A stale or edited entry is a reason to tune again, not to fail at the start
+    bool is_known_calc_method = std::ranges::find(shallow_calc_method_candidates, profile.calc_method) !=
+                                std::end(shallow_calc_method_candidates);
+    bool is_known_deep_calc_method = std::ranges::find(deep_calc_method_candidates, profile.deep_calc_method) !=
+                                     std::end(deep_calc_method_candidates);
+    if (profile.threads_count != threads_count || !is_known_calc_method || !is_known_deep_calc_method ||
+        profile.rows_per_task < 1 || !(profile.deep_pixel_size > 0))
+    {
+        return std::nullopt;
+    }
+    return profile;
+}
+
+void TuningProfile::save(std::string const& file_path) const
+{
+    std::ofstream file { file_path };
+    file << "threads_count " << threads_count << '\n'
+         << "calc_method " << calc_method << '\n'
+         << "rows_per_task " << rows_per_task << '\n'
+         << "deep_calc_method " << deep_calc_method << '\n'
+         << "deep_pixel_size " << std::format("{:e}", deep_pixel_size) << '\n';
+}
+
+std::shared_ptr<FractalCalcMethod> TuningProfile::makeCalcMethod() const
+{
+    std::shared_ptr<FractalCalcMethod> shallow_calc_method =
+        calc_method == "rows"
+        ? std::make_shared<CalcFractalByRowsParallel<>>(MandelbrotFormula { }, rows_per_task)
+        : makeCalcMethodByName(calc_method);
+    return std::make_shared<CalcFractalByPrecisionTier>(shallow_calc_method, makeCalcMethodByName(deep_calc_method),
+                                                        deep_pixel_size);
+}
+
+TuningProfile tuneCalcMethods(std::ostream& log)
+{
+    TuningProfile profile;
+    profile.threads_count = ThreadPoolSimpleInstance::get().threadsCount();
+
+    tuneShallowTier(profile, log);
+    Real imprecise_pixel_size = findFirstImpreciseDepth(profile, *makeCalcMethodByName(profile.calc_method), log);
+    tuneDeepTier(profile, imprecise_pixel_size, log);
+    return profile;
+}
+
+std::shared_ptr<FractalCalcMethod> makeTunedCalcMethod(std::string const& profile_path, bool is_retune_forced)
+{
+    std::size_t threads_count = ThreadPoolSimpleInstance::get().threadsCount();
+    std::optional<TuningProfile> profile;
+    if (!is_retune_forced)
+    {
+        profile = TuningProfile::load(profile_path, threads_count);
+    }
+    if (!profile)
+    {
+        profile = tuneCalcMethods(std::clog);
+        profile->save(profile_path);
+    }
+
+    std::clog << std::format("Calc method: {} by {} rows, {} below {:.0e} pixel\n", profile->calc_method,
+                             profile->rows_per_task, profile->deep_calc_method, double(profile->deep_pixel_size));
+    return profile->makeCalcMethod();
+}
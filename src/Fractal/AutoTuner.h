@@ -0,0 +1,35 @@
+#ifndef MANDELBROT_CPP_AUTOTUNER_H
+#define MANDELBROT_CPP_AUTOTUNER_H
+
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include "FractalCalcMethods.h"
+
+// Fastest Mandelbrot setup measured on this host with its thread pool
+struct TuningProfile
+{
+    std::size_t threads_count = 0;
+    std::string calc_method = "rows";
+    int rows_per_task = 1;
+
+    // Below this pixel size long double iterations differ from the 256-bit ones
+    std::string deep_calc_method = "fixed128";
+    Real deep_pixel_size = 1e-16L;
+
+    // Empty when the file is missing, broken or was written for another threads count
+    static std::optional<TuningProfile> load(std::string const& file_path, std::size_t threads_count);
+
+    void save(std::string const& file_path) const;
+
+    [[nodiscard]] std::shared_ptr<FractalCalcMethod> makeCalcMethod() const;
+};
+
+// Short calibration over the calc methods, rows per task and the precision tiers, progress goes to the log
+TuningProfile tuneCalcMethods(std::ostream& log);
+
+// Takes the cached profile unless it's missing or the tuning is forced, then tunes and caches the new one
+std::shared_ptr<FractalCalcMethod> makeTunedCalcMethod(std::string const& profile_path, bool is_retune_forced);
+
+#endif //MANDELBROT_CPP_AUTOTUNER_H
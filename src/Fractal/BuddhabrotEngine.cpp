@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "BuddhabrotEngine.h"
+#include "TaskIterators.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+
+namespace
+{
+    constexpr int rows_per_merge_task = 16;
+    constexpr int max_start_search_samples = 100'000;
+
+    // Main cardioid and period-2 bulb never escape
+    bool isInMainBulbs(double c_re, double c_im)
+    {
+        double q = (c_re - 0.25) * (c_re - 0.25) + c_im * c_im;
+        return q * (q + (c_re - 0.25)) <= 0.25 * c_im * c_im || (c_re + 1) * (c_re + 1) + c_im * c_im <= 0.0625;
+    }
+}
+
+double BuddhabrotEngine::Statistics::samplesPerSecond() const
+{
+    return double(samples_count) / spent_time.count();
+}
+
+BuddhabrotEngine::BuddhabrotEngine(ProgramConfig const& program_config)
+    : config { program_config.buddhabrot_config }
+    , width { unsigned(program_config.axis.screen_borders.x.max) }
+    , height { unsigned(program_config.axis.screen_borders.y.max) }
+    , view_re { double(program_config.axis.cartesian_borders.x.min), double(program_config.axis.cartesian_borders.x.max) }
+    , view_im { double(program_config.axis.cartesian_borders.y.min), double(program_config.axis.cartesian_borders.y.max) }
+    , bright_color { program_config.color_table_config.color_range.max }
+{ }
+
+BuddhabrotEngine::Statistics BuddhabrotEngine::sample()
+{
+    auto begin = std::chrono::steady_clock::now();
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    std::size_t shards_count = thread_pool.threadsCount();
+    shards.assign(shards_count, { });
+    shard_statistics.assign(shards_count, { });
+
+    auto shard_task = [this, shards_count](int shard)
+    {
+        auto shard_index = std::size_t(shard);
+        std::size_t samples_count = config.samples_count / shards_count +
+                                    (shard_index < config.samples_count % shards_count ? 1 : 0);
+
+        // Allocated by the task, so the pages are placed near the thread that fills them
+        shards[shard_index].assign(std::size_t(width) * height, 0.0);
+        config.is_metropolis
+            ? sampleMetropolis(shard_index, samples_count)
+            : sampleUniform(shard_index, samples_count);
+    };
+    auto shards_latch = thread_pool.addTasks(RowTasksIterator<decltype(shard_task)> { shard_task, int(shards_count) });
+    thread_pool.joinMainToWorkers(*shards_latch);
+    mergeShards();
+
+    Statistics statistics;
+    for (ShardStatistics const& shard: shard_statistics)
+    {
+        statistics.samples_count += shard.samples_count;
+        statistics.start_search_samples_count += shard.start_search_samples_count;
+        statistics.contributing_samples_count += shard.contributing_samples_count;
+        statistics.accepted_count += shard.accepted_count;
+    }
+    statistics.spent_time = std::chrono::steady_clock::now() - begin;
+    return statistics;
+}
+
+std::vector<double> const& BuddhabrotEngine::density() const
+{
+    static std::vector<double> const not_sampled;
+    return shards.empty() ? not_sampled : shards.front();
+}
+
+void BuddhabrotEngine::saveImage(std::string const& file_path) const
+{
+    std::vector<double> const& histogram = density();
+    if (histogram.empty())
+    {
+        throw std::logic_error("Nothing is sampled to save");
+    }
+    double max_density = *std::max_element(histogram.begin(), histogram.end());
+
+    sf::Image image;
+    image.create(width, height);
+    MinMax<Real> brightness_range = { 0, 1 };
+    for (unsigned py = 0; py != height; ++py)
+    {
+        for (unsigned px = 0; px != width; ++px)
+        {
+            double value = histogram[std::size_t(py) * width + px];
+            Real brightness = max_density > 0 ? Real(std::sqrt(value / max_density)) : 0;
+            image.setPixel(px, py, brightness_range.lerp(brightness, MinMax<sf::Color> { sf::Color::Black, bright_color }));
+        }
+    }
+    if (!image.saveToFile(file_path))
+    {
+        throw std::runtime_error("Can't write " + file_path);
+    }
+}
+
+void BuddhabrotEngine::sampleUniform(std::size_t shard_index, std::size_t samples_count)
+{
+    std::vector<double>& histogram = shards[shard_index];
+    ShardStatistics& statistics = shard_statistics[shard_index];
+    std::mt19937_64 random { shard_index + 1 };
+    std::uniform_real_distribution<double> random_coordinate(-2, 2);
+    std::vector<std::uint32_t> hits;
+
+    for (std::size_t i = 0; i != samples_count; ++i)
+    {
+        double c_re = random_coordinate(random);
+        traceOrbit(c_re, random_coordinate(random), hits);
+        for (std::uint32_t hit: hits)
+        {
+            histogram[hit] += 1;
+        }
+        statistics.contributing_samples_count += !hits.empty();
+    }
+    statistics.samples_count += samples_count;
+}
+
+void BuddhabrotEngine::sampleMetropolis(std::size_t shard_index, std::size_t samples_count)
+{
+    std::vector<double>& histogram = shards[shard_index];
+    ShardStatistics& statistics = shard_statistics[shard_index];
+    std::mt19937_64 random { shard_index + 1 };
+    std::uniform_real_distribution<double> random_coordinate(-2, 2);
+    std::uniform_real_distribution<double> random_probability(0, 1);
+    std::normal_distribution<double> random_mutation(0, config.mutation_size * (view_re.max - view_re.min));
+
+    // The walk starts from any contributing orbit
+    std::vector<std::uint32_t> hits;
+    double c_re = 0, c_im = 0;
+    std::size_t i = 0;
+    for (; i != samples_count && i != max_start_search_samples && hits.empty(); ++i)
+    {
+        c_re = random_coordinate(random);
+        c_im = random_coordinate(random);
+        traceOrbit(c_re, c_im, hits);
+    }
+    std::size_t start_search_samples_count = i;
+    statistics.start_search_samples_count += start_search_samples_count;
+
+    std::vector<std::uint32_t> proposal_hits;
+    for (; i < samples_count && !hits.empty(); ++i)
+    {
+        bool is_restart = random_probability(random) < config.random_restart_probability;
+        double proposal_re = is_restart ? random_coordinate(random) : c_re + random_mutation(random);
+        double proposal_im = is_restart ? random_coordinate(random) : c_im + random_mutation(random);
+        traceOrbit(proposal_re, proposal_im, proposal_hits);
+        statistics.contributing_samples_count += !proposal_hits.empty();
+
+        // Symmetric proposals: the acceptance is the ratio of the contributions
+        if (!proposal_hits.empty() &&
+            random_probability(random) * double(hits.size()) < double(proposal_hits.size()))
+        {
+            c_re = proposal_re;
+            c_im = proposal_im;
+            hits.swap(proposal_hits);
+            ++statistics.accepted_count;
+        }
+
+        // Samples come proportionally to the contribution, the weight brings every orbit back to 1
+        double weight = 1 / double(hits.size());
+        for (std::uint32_t hit: hits)
+        {
+            histogram[hit] += weight;
+        }
+    }
+    statistics.samples_count += i - start_search_samples_count;
+}
+
+void BuddhabrotEngine::mergeShards()
+{
+    auto merge_task = [this](int task)
+    {
+        std::size_t begin = std::size_t(task) * rows_per_merge_task * width;
+        std::size_t end = std::min(begin + std::size_t(rows_per_merge_task) * width, std::size_t(width) * height);
+        std::vector<double>& merged = shards.front();
+        for (std::size_t shard = 1; shard != shards.size(); ++shard)
+        {
+            for (std::size_t i = begin; i != end; ++i)
+            {
+                merged[i] += shards[shard][i];
+            }
+        }
+    };
+    int tasks_count = (int(height) + rows_per_merge_task - 1) / rows_per_merge_task;
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto merge_latch = thread_pool.addTasks(RowTasksIterator<decltype(merge_task)> { merge_task, tasks_count });
+    thread_pool.joinMainToWorkers(*merge_latch);
+    shards.resize(1);
+}
+
+void BuddhabrotEngine::traceOrbit(double c_re, double c_im, std::vector<std::uint32_t>& hits) const
+{
+    hits.clear();
+    if (!config.is_anti && isInMainBulbs(c_re, c_im))
+    {
+        return;
+    }
+
+    double x_scale = width / (view_re.max - view_re.min);
+    double y_scale = height / (view_im.max - view_im.min);
+    double re = 0, im = 0;
+    std::size_t i = 0;
+    for (; i != config.max_iterations_count; ++i)
+    {
+        double next_re = re * re - im * im + c_re;
+        im = 2 * re * im + c_im;
+        re = next_re;
+        if (re * re + im * im > 4)
+        {
+            break;
+        }
+
+        double px = (re - view_re.min) * x_scale;
+        double py = (im - view_im.min) * y_scale;
+        if (px >= 0 && py >= 0 && px < width && py < height)
+        {
+            hits.push_back(std::uint32_t(py) * width + std::uint32_t(px));
+        }
+    }
+
+    bool is_escaped = i != config.max_iterations_count;
+    if (is_escaped == config.is_anti || i < config.min_iterations_count)
+    {
+        hits.clear();
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef MANDELBROT_CPP_BUDDHABROTENGINE_H
+#define MANDELBROT_CPP_BUDDHABROTENGINE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Config.h"
+
+// Samples c over the |c| < 2 disk and accumulates the pixels visited by the orbits of the contributing c.
+// Every task of the thread pool owns one histogram shard, so the hot path takes no locks,
+// then the shards are summed row band by row band in parallel.
+// Metropolis sampling walks between contributing orbits, each orbit is weighted by 1 / its contribution,
+// so the density stays unbiased while most of the samples land on orbits that reach the view
+class BuddhabrotEngine
+{
+public:
+    struct Statistics
+    {
+        // Without the samples that searched for the start of a Metropolis walk
+        std::size_t samples_count = 0;
+        std::size_t start_search_samples_count = 0;
+        std::size_t contributing_samples_count = 0;
+        std::size_t accepted_count = 0;
+        std::chrono::duration<double> spent_time { };
+
+        [[nodiscard]] double samplesPerSecond() const;
+    };
+
+public:
+    explicit BuddhabrotEngine(ProgramConfig const& program_config);
+
+    Statistics sample();
+
+    // Empty before sample()
+    [[nodiscard]] std::vector<double> const& density() const;
+
+    // Square root tone mapping from black to the end color of the color range
+    void saveImage(std::string const& file_path) const;
+
+private:
+    // alignas: the statistics of the tasks don't share cache lines
+    struct alignas(64) ShardStatistics
+    {
+        std::size_t samples_count = 0;
+        std::size_t start_search_samples_count = 0;
+        std::size_t contributing_samples_count = 0;
+        std::size_t accepted_count = 0;
+    };
+
+    void sampleUniform(std::size_t shard_index, std::size_t samples_count);
+    void sampleMetropolis(std::size_t shard_index, std::size_t samples_count);
+    void mergeShards();
+
+    // Histogram indices visited by the orbit of c, empty when the orbit doesn't contribute
+    void traceOrbit(double c_re, double c_im, std::vector<std::uint32_t>& hits) const;
+
+private:
+    BuddhabrotConfig config;
+    unsigned width;
+    unsigned height;
+    MinMax<double> view_re;
+    MinMax<double> view_im;
+    sf::Color bright_color;
+
+    std::vector<std::vector<double>> shards;
+    std::vector<ShardStatistics> shard_statistics;
+};
+
+#endif //MANDELBROT_CPP_BUDDHABROTENGINE_H
@@ -0,0 +1,24 @@
+#include <limits>
+#include "ColorTable.h"
+
+ColorTable::ColorTable(ColorTableConfig const& color_table_config)
+{
+    colors.resize(color_table_config.transition_color_smoothness);
+
+    MinMax<std::size_t> color_table_index_range = {
+        0, std::size(colors) / color_table_config.transition_colors_count
+    };
+
+    for (std::size_t i = 0; i != std::size(colors); ++i)
+    {
+        colors[i] = color_table_index_range.lerp(i, color_table_config.color_range);
+    }
+}
+
+sf::Color ColorTable::colorOf(std::size_t spent_iterations) const
+{
+    bool is_in_set = spent_iterations == std::numeric_limits<std::size_t>::max();
+    return is_in_set
+           ? sf::Color::Black
+           : colors[spent_iterations % std::size(colors)];
+}
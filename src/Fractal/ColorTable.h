@@ -0,0 +1,20 @@
+#ifndef MANDELBROT_CPP_COLORTABLE_H
+#define MANDELBROT_CPP_COLORTABLE_H
+
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "Config.h"
+
+class ColorTable
+{
+public:
+    explicit ColorTable(ColorTableConfig const& color_table_config);
+
+    // Black for the points of the set, the cyclic color gradient for the escaped ones
+    [[nodiscard]] sf::Color colorOf(std::size_t spent_iterations) const;
+
+private:
+    std::vector<sf::Color> colors;
+};
+
+#endif //MANDELBROT_CPP_COLORTABLE_H
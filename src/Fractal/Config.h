@@ -3,6 +3,7 @@
 
 #include "../Utility/Types.h"
 #include "FractalCalcMethods.h"
+#include "../Multithreading/ThreadPoolConfig.h"
 
 struct ColorTableConfig
 {
@@ -11,16 +12,110 @@ struct ColorTableConfig
     std::size_t transition_colors_count = 2;
 };
 
+struct JuliaPreviewConfig
+{
+    bool is_enabled = true;
+
+    // Preview work submitted to the thread pool per frame
+    std::chrono::microseconds frame_budget = std::chrono::milliseconds(4);
+
+    // Resting cursor refines the preview level by level
+    std::chrono::milliseconds cursor_rest_time = std::chrono::milliseconds(150);
+    unsigned panel_size = 256;
+};
+
+// Slippy-map tiles: zoom z splits the world square into 2^z x 2^z tiles, y goes down
+struct TileServerConfig
+{
+    unsigned short port = 8080;
+    unsigned tile_size = 256;
+    Complex world_top_left = { -2.5L, 2 };
+    Real world_size = 4;
+
+    // A tile pixel of the deepest zoom is still wider than the long double precision
+    int max_zoom = 48;
+    std::size_t base_iterations_count = 200;
+    std::size_t iterations_per_zoom = 40;
+
+    std::size_t max_cached_tiles = 4096;
+    std::size_t connection_threads_count = 16;
+
+    // The server stops after that many connections, 0 - only on SIGINT or SIGTERM
+    std::size_t max_requests_count = 0;
+
+    // Load generator: every client requests tiles of random zooms up to load_max_zoom one by one
+    std::size_t load_clients_count = 16;
+    std::size_t load_requests_per_client = 64;
+    int load_max_zoom = 5;
+};
+
+// Smooth zoom into the center, the frame height shrinks by zoom_depth over the duration
+struct ZoomVideoConfig
+{
+    Complex center = { -0.743643887037151L, 0.131825904205330L };
+    Real start_half_height = 1.5L;
+    Real zoom_depth = 1e10L;
+    unsigned frame_width = 640;
+    unsigned frame_height = 360;
+    unsigned frames_per_second = 30;
+    unsigned duration_seconds = 60;
+    std::size_t base_iterations_count = 200;
+    std::size_t iterations_per_decade = 150;
+};
+
+// Density of the orbits: escaping ones for the Buddhabrot, bounded ones for the anti-Buddhabrot.
+// The image covers ProgramConfig::axis
+struct BuddhabrotConfig
+{
+    bool is_anti = false;
+    std::size_t samples_count = 20'000'000;
+    std::size_t max_iterations_count = 2'000;
+    std::size_t min_iterations_count = 20;
+
+    // Metropolis: mutations move c by a normal step of mutation_size of the view width,
+    // random_restart_probability of the proposals are uniform ones
+    bool is_metropolis = true;
+    double mutation_size = 0.01;
+    double random_restart_probability = 0.2;
+};
+
+// Large image of the start view rendered tile by tile. Finished tiles go to a journal next to the image,
+// so an interrupted render resumes from the missing tiles
+struct PosterConfig
+{
+    unsigned width = 8192;
+    unsigned height = 6144;
+    unsigned tile_size = 256;
+    std::size_t iterations_count = 2'000;
+
+    // The journal is flushed to the disk not more often than that
+    std::chrono::milliseconds sync_interval = std::chrono::seconds(2);
+};
+
 struct ProgramConfig
 {
     MinMax<int> iterations_limit = { 20, 10'000 };
+    bool is_auto_iterations = false;
     double initial_zoom_rect_ratio = 0.8;
     sf::VideoMode window_mode = { 1024, 768 };
     ColorTableConfig color_table_config;
+    JuliaPreviewConfig julia_preview_config;
+    TileServerConfig tile_server_config;
+    ZoomVideoConfig zoom_video_config;
+    BuddhabrotConfig buddhabrot_config;
+    PosterConfig poster_config;
     Axis axis = { PlaneBorders<Real> { MinMax<Real> { -2, 1 }, MinMax<Real> { -1, 1 }},
                   PlaneBorders<int> { MinMax<int> { 0, int(window_mode.width) },
                                       MinMax<int> { 0, int(window_mode.height) }}};
-    std::shared_ptr<FractalCalcMethod> calc_method = std::make_shared<CalcFractalByRowsParallel>();
+    std::shared_ptr<FractalCalcMethod> calc_method = std::make_shared<CalcFractalByRowsParallel<>>();
+
+    // Calc method measured on this host, used when none is given on the command line
+    std::string tuning_profile_path = "mandelbrot_tuning.txt";
+    ThreadPoolConfig thread_pool_config;
+    bool is_first_touch_image_buffer = true;
+
+    // Interactions and the views they produce are written there for the replay benchmark, empty to disable
+    std::string interaction_log_path;
 };
 
 #endif //MANDELBROT_CPP_CONFIG_H
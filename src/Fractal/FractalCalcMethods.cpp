@@ -1,72 +1,861 @@
-#include <iostream>
+#include <optional>
+#include <unordered_map>
 #include "FractalCalcMethods.h"
 #include "TaskIterators.h"
+#include "PrecisionKernels.h"
+#include "../Utility/FixedPoint.h"
+#include "MpnEscapeEngine.h"
 #include "../Multithreading/ThreadPoolInstance.h"
+#include "../Multithreading/PerfProfiler.h"
 
-std::size_t FractalCalcMethod::isInFractalBody(std::size_t iterations_count, Complex c)
+namespace
 {
+    constexpr Real cycle_tolerance_square = 1e-20L;
+
+    Complex add(Complex a, Complex b)
+    {
+        return { a.re + b.re, a.im + b.im };
+    }
+
+    Complex subtract(Complex a, Complex b)
+    {
+        return { a.re - b.re, a.im - b.im };
+    }
+
+    Complex multiply(Complex a, Complex b)
+    {
+        return { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+    }
+
+    Complex divide(Complex a, Complex b)
+    {
+        Real b_norm = b.re * b.re + b.im * b.im;
+        return { (a.re * b.re + a.im * b.im) / b_norm, (a.im * b.re - a.re * b.im) / b_norm };
+    }
+
+    Real normOf(Complex a)
+    {
+        return a.re * a.re + a.im * a.im;
+    }
+
+    // z_period from w and its derivatives at w
+    struct CycleDerivatives
+    {
+        Complex z { 0, 0 };
+        Complex dz { 1, 0 };
+        Complex dc { 0, 0 };
+        Complex dz_dz { 0, 0 };
+        Complex dc_dz { 0, 0 };
+    };
+
+    CycleDerivatives iterateCycle(Complex w, Complex c, std::size_t period)
+    {
+        CycleDerivatives cycle;
+        cycle.z = w;
+        for (std::size_t n = 0; n != period; ++n)
+        {
+            // Each derivative by the previous values: d(z^2 + c) = 2*z*dz, and so on
+            Complex z = cycle.z;
+            Complex two_z { 2 * z.re, 2 * z.im };
+            cycle.dc_dz = add(multiply(two_z, cycle.dc_dz), multiply({ 2 * cycle.dc.re, 2 * cycle.dc.im }, cycle.dz));
+            cycle.dz_dz = add(multiply(two_z, cycle.dz_dz), multiply({ 2 * cycle.dz.re, 2 * cycle.dz.im }, cycle.dz));
+            cycle.dc = add(multiply(two_z, cycle.dc), { 1, 0 });
+            cycle.dz = multiply(two_z, cycle.dz);
+            cycle.z = Complex { z.re * z.re - z.im * z.im + c.re, 2 * z.re * z.im + c.im };
+            if (normOf(cycle.z) > 4)
+            {
+                return { };
+            }
+        }
+        return cycle;
+    }
+
+    // Newton's method on z_period(w) = w from the orbit point z. Interior distance when the cycle is attracting:
+    // the true distance lies between a quarter of (1 - |dz|^2) / |dc_dz + dz_dz * dc / (1 - dz)| and the whole of it
+    std::optional<Real> findAttractingCycle(Complex z, Complex c, std::size_t period)
+    {
+        constexpr int max_newton_steps = 16;
+
+        Complex w = z;
+        for (int step = 0; step != max_newton_steps; ++step)
+        {
+            CycleDerivatives cycle = iterateCycle(w, c, period);
+            Complex slope = subtract(cycle.dz, { 1, 0 });
+            if (!(normOf(slope) > 0))
+            {
+                return std::nullopt;
+            }
+            Complex shift = divide(subtract(cycle.z, w), slope);
+            w = subtract(w, shift);
+            if (!(normOf(shift) > cycle_tolerance_square * cycle_tolerance_square))
+            {
+                break;
+            }
+        }
+
+        CycleDerivatives cycle = iterateCycle(w, c, period);
+        if (!(normOf(w) <= 4) || !(normOf(subtract(cycle.z, w)) < cycle_tolerance_square) ||
+            !(normOf(cycle.dz) < 1))
+        {
+            return std::nullopt;
+        }
+
+        Complex denominator = add(cycle.dc_dz, multiply(cycle.dz_dz, divide(cycle.dc, subtract({ 1, 0 }, cycle.dz))));
+        Real interior_distance = (1 - normOf(cycle.dz)) / std::sqrt(normOf(denominator)) / 4;
+        return std::isfinite(interior_distance) ? interior_distance : 0;
+    }
+}
+
+FractalCalcMethod::DistanceEstimate FractalCalcMethod::estimateDistance(std::size_t iterations_count, Complex c)
+{
+    // Bigger escape radius makes the estimate accurate, 2 still defines the spent iterations
+    constexpr Real escape_radius_square = 1e20L;
+
     Complex z = { 0, 0 };
+    Complex dz_dc = { 0, 0 };
+    std::size_t spent_iterations = std::numeric_limits<std::size_t>::max();
+
+    // Brent's cycle detection: the orbit is compared with its point at the last power of two
+    Complex saved_z = z;
+    std::size_t saved_i = 0;
+    bool is_saved_z_checked = true;
 
-    for (std::size_t i = 0; i != iterations_count; ++i)
+    for (std::size_t i = 0; i != iterations_count || spent_iterations != std::numeric_limits<std::size_t>::max(); ++i)
     {
-        // z*z + c
+        // dz/dc = 2*z*dz/dc + 1
+        dz_dc = Complex { 2 * (z.re * dz_dc.re - z.im * dz_dc.im) + 1, 2 * (z.re * dz_dc.im + z.im * dz_dc.re) };
         z = Complex { z.re * z.re - z.im * z.im + c.re, 2 * z.re * z.im + c.im };
 
-        // Math theorem.
-        // For any point in the complex plane, we assign a value to k and iterate.
-        // if at any particular moment of calculations, for k, the distance from zi(k) to the origin
-        // is greater than 2, then we can assume that the given {Zn(k)} will go to infinity
-        // (In comparison: the distance is 2, so its square is less than 4 and the square root no need to calcFractal)
-        if (z.re * z.re + z.im * z.im > 4)
+        Real z_abs_square = z.re * z.re + z.im * z.im;
+        if (z_abs_square > 4 && spent_iterations == std::numeric_limits<std::size_t>::max())
+        {
+            spent_iterations = i;
+        }
+        if (z_abs_square > escape_radius_square)
         {
-            return i;
+            // Koebe 1/4 theorem: the true distance is at least a quarter of 2*|z|*ln|z|/|dz/dc|
+            Real z_abs = std::sqrt(z_abs_square);
+            Real dz_dc_abs = std::hypot(dz_dc.re, dz_dc.im);
+            return { spent_iterations, Real(0.5) * z_abs * std::log(z_abs) / dz_dc_abs };
+        }
+
+        if (spent_iterations == std::numeric_limits<std::size_t>::max())
+        {
+            if (!is_saved_z_checked && normOf(subtract(z, saved_z)) < cycle_tolerance_square)
+            {
+                if (auto interior_distance = findAttractingCycle(z, c, i - saved_i))
+                {
+                    return { spent_iterations, 0, true, *interior_distance };
+                }
+                is_saved_z_checked = true;
+            }
+            if ((i & (i + 1)) == 0)
+            {
+                saved_z = z;
+                saved_i = i;
+                is_saved_z_checked = false;
+            }
         }
     }
 
-    return std::numeric_limits<std::size_t>::max();
+    return { spent_iterations, 0 };
 }
 
-void CalcFractalByRowsParallel::calcFractal(std::size_t iterations_count, const Axis& axis,
-                                            ResultCallback callbackSetResult)
+FractalCalcMethod::ConjugateRows FractalCalcMethod::findConjugateRows(const Axis& axis, bool is_conjugate_symmetric)
 {
-    auto row_task = [&axis, iterations_count, callbackSetResult](int py)
+    int rows_count = axis.screen_borders.y.max;
+    std::unordered_map<Real, int> row_by_im;
+    if (is_conjugate_symmetric && axis.cartesian_borders.y.min * axis.cartesian_borders.y.max < 0)
     {
-        for (int px = 0; px != axis.screen_borders.x.max; ++px)
+        for (int py = 0; py != rows_count; ++py)
+        {
+            row_by_im.emplace(axis.screenToCartesianY(py), py);
+        }
+    }
+
+    // Negative rows compute for their positive twins
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    std::vector<int> mirror_of_row(std::size_t(rows_count), -1);
+    std::vector<bool> is_row_mirrored(std::size_t(rows_count), false);
+    for (int py = 0; py != rows_count && !row_by_im.empty(); ++py)
+    {
+        Real im = axis.screenToCartesianY(py);
+        if (im >= 0)
+        {
+            continue;
+        }
+        auto twin = row_by_im.find(-im);
+        if (twin != row_by_im.end() &&
+            thread_pool.groupOfRow(py, rows_count) == thread_pool.groupOfRow(twin->second, rows_count))
+        {
+            mirror_of_row[std::size_t(py)] = twin->second;
+            is_row_mirrored[std::size_t(twin->second)] = true;
+        }
+    }
+
+    ConjugateRows rows;
+    for (int py = 0; py != rows_count; ++py)
+    {
+        if (!is_row_mirrored[std::size_t(py)])
+        {
+            rows.computed_rows.push_back(py);
+            rows.mirrored_rows.push_back(mirror_of_row[std::size_t(py)]);
+        }
+    }
+    return rows;
+}
+
+std::size_t FractalCalcMethod::calcPoint(std::size_t iterations_count, Complex point) const
+{
+    return isInFractalBody(iterations_count, point);
+}
+
+FractalCalcMethod const& FractalCalcMethod::methodForPixelSize(Real) const
+{
+    return *this;
+}
+
+std::string FractalCalcMethod::formulaName() const
+{
+    return MandelbrotFormula::name();
+}
+
+std::vector<FractalCalcMethod::PixelsShare> FractalCalcMethod::lastFramePixelsShares() const
+{
+    return { };
+}
+
+template<class Formula>
+void CalcFractalByRowsParallel<Formula>::calcFractal(std::size_t iterations_count, const Axis& axis,
+                                                     FractalCalcMethod::ResultCallback callbackSetResult)
+{
+    // Mirrored rows are filled by the same task as their twins
+    FractalCalcMethod::ConjugateRows rows = FractalCalcMethod::findConjugateRows(axis, Formula::is_conjugate_symmetric);
+    auto rows_count = int(rows.computed_rows.size());
+    auto rows_task = [this, &axis, &rows, iterations_count, callbackSetResult, rows_count](int task)
+    {
+        int row_end = std::min((task + 1) * rows_per_task, rows_count);
+        for (int row = task * rows_per_task; row < row_end; ++row)
         {
+            int py = rows.computed_rows[std::size_t(row)];
+            int mirrored_py = rows.mirrored_rows[std::size_t(row)];
+            for (int px = 0; px != axis.screen_borders.x.max; ++px)
+            {
+                Complex c { axis.screenToCartesianX(px), axis.screenToCartesianY(py) };
+                std::size_t spent_iterations = this->calcPoint(iterations_count, c);
+                callbackSetResult(spent_iterations, px, py);
+                if (mirrored_py != -1)
+                {
+                    callbackSetResult(spent_iterations, px, mirrored_py);
+                }
+            }
+        }
+    };
+    int tasks_count = (rows_count + rows_per_task - 1) / rows_per_task;
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto group_of_task = [&thread_pool, &axis, &rows, this](int task)
+    {
+        return thread_pool.groupOfRow(rows.computed_rows[std::size_t(task * rows_per_task)], axis.screen_borders.y.max);
+    };
+    auto rows_latch = thread_pool.addTasks(RowTasksIterator<decltype(rows_task)> { rows_task, tasks_count },
+                                           group_of_task);
+    thread_pool.joinMainToWorkers(*rows_latch);
+}
+
+namespace
+{
+    // Points of the set run the whole iterations count
+    double pixelCost(std::size_t spent_iterations, std::size_t iterations_count)
+    {
+        return spent_iterations == std::numeric_limits<std::size_t>::max()
+               ? double(iterations_count) + 1
+               : double(spent_iterations) + 1;
+    }
+}
+
+template<class Formula>
+double CalcFractalByCostBalance<Formula>::CostMap::costAt(Real x, Real y) const
+{
+    Real px = (x - axis.screenToCartesianX(0)) / (axis.screenToCartesianX(1) - axis.screenToCartesianX(0));
+    Real py = (y - axis.screenToCartesianY(0)) / (axis.screenToCartesianY(1) - axis.screenToCartesianY(0));
+    auto column = int(std::clamp(px / Real(cell_width), Real(0), Real(columns - 1)));
+    auto row = int(std::clamp(py / Real(cell_height), Real(0), Real(rows - 1)));
+    return costs[std::size_t(row) * std::size_t(columns) + std::size_t(column)];
+}
+
+template<class Formula>
+double CalcFractalByCostBalance<Formula>::CostMap::coverage(Axis const& view) const
+{
+    if (costs.empty())
+    {
+        return 0;
+    }
+    auto overlap = [](MinMax<Real> const& map, MinMax<Real> const& view_borders)
+    {
+        Real common = std::min(map.max, view_borders.max) - std::max(map.min, view_borders.min);
+        return std::max(common, Real(0)) / (view_borders.max - view_borders.min);
+    };
+    return double(overlap(axis.cartesian_borders.x, view.cartesian_borders.x) *
+                  overlap(axis.cartesian_borders.y, view.cartesian_borders.y));
+}
+
+template<class Formula>
+typename CalcFractalByCostBalance<Formula>::CostMap
+CalcFractalByCostBalance<Formula>::measureCoarseCosts(std::size_t iterations_count, Axis const& axis) const
+{
+    PerfPhase phase("cost pre-pass");
+    CostMap coarse_costs;
+    coarse_costs.axis = axis;
+    coarse_costs.iterations_count = iterations_count;
+    coarse_costs.cell_width = coarse_cell_size;
+    coarse_costs.cell_height = coarse_cell_size;
+    coarse_costs.columns = (axis.screen_borders.x.max + coarse_cell_size - 1) / coarse_cell_size;
+    coarse_costs.rows = (axis.screen_borders.y.max + coarse_cell_size - 1) / coarse_cell_size;
+    coarse_costs.costs.resize(std::size_t(coarse_costs.columns) * std::size_t(coarse_costs.rows));
+
+    auto row_task = [this, &axis, &coarse_costs, iterations_count](int row)
+    {
+        int py = std::min(row * coarse_cell_size + coarse_cell_size / 2, axis.screen_borders.y.max - 1);
+        for (int column = 0; column != coarse_costs.columns; ++column)
+        {
+            int px = std::min(column * coarse_cell_size + coarse_cell_size / 2, axis.screen_borders.x.max - 1);
             Complex c { axis.screenToCartesianX(px), axis.screenToCartesianY(py) };
-            std::size_t spent_iterations = isInFractalBody(iterations_count, c);
-            callbackSetResult(spent_iterations, px, py);
+            coarse_costs.costs[std::size_t(row) * std::size_t(coarse_costs.columns) + std::size_t(column)] =
+                pixelCost(this->calcPoint(iterations_count, c), iterations_count);
+        }
+    };
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto rows_latch = thread_pool.addTasks(RowTasksIterator<decltype(row_task)> { row_task, coarse_costs.rows });
+    thread_pool.joinMainToWorkers(*rows_latch);
+    return coarse_costs;
+}
+
+template<class Formula>
+std::vector<typename CalcFractalByCostBalance<Formula>::Chunk>
+CalcFractalByCostBalance<Formula>::makeChunks(std::size_t iterations_count, Axis const& axis,
+                                              std::vector<int> const& computed_rows) const
+{
+    CostMap coarse_costs;
+    bool is_previous_usable = previous_costs.iterations_count == iterations_count &&
+                              previous_costs.coverage(axis) >= min_coverage;
+    if (!is_previous_usable)
+    {
+        coarse_costs = measureCoarseCosts(iterations_count, axis);
+    }
+    CostMap const& cost_map = is_previous_usable ? previous_costs : coarse_costs;
+
+    std::vector<Real> samples_x;
+    for (int px = cost_cell_size / 2; px < axis.screen_borders.x.max; px += cost_cell_size)
+    {
+        samples_x.push_back(axis.screenToCartesianX(px));
+    }
+    std::vector<double> row_costs(computed_rows.size(), 0.0);
+    double total_cost = 0;
+    for (std::size_t row = 0; row != computed_rows.size(); ++row)
+    {
+        Real y = axis.screenToCartesianY(computed_rows[row]);
+        for (Real x: samples_x)
+        {
+            row_costs[row] += cost_map.costAt(x, y);
+        }
+        total_cost += row_costs[row];
+    }
+
+    // Adjacent rows up to a half of the remaining share of a thread, so the chunks shrink towards the end
+    // of the frame, down to smallest_chunk_share of the full share. A chunk doesn't cross the row range of a thread group,
+    // the idle groups take the chunks of the other ranges, so the balance holds across the groups too
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto threads_count = double(thread_pool.threadsCount());
+    double min_chunk_cost = total_cost / threads_count * smallest_chunk_share;
+    double remaining_cost = total_cost;
+    std::vector<Chunk> chunks;
+    Chunk chunk { 0, 0, 0 };
+    for (int row = 0; row != int(computed_rows.size()); ++row)
+    {
+        chunk.end = row + 1;
+        chunk.cost += row_costs[std::size_t(row)];
+        bool is_group_end = row + 1 != int(computed_rows.size()) &&
+                            thread_pool.groupOfRow(computed_rows[std::size_t(row)], axis.screen_borders.y.max) !=
+                            thread_pool.groupOfRow(computed_rows[std::size_t(row) + 1], axis.screen_borders.y.max);
+        if (is_group_end || chunk.cost >= std::max(remaining_cost / threads_count / 2, min_chunk_cost))
+        {
+            remaining_cost -= chunk.cost;
+            chunks.push_back(chunk);
+            chunk = Chunk { row + 1, row + 1, 0 };
+        }
+    }
+    if (chunk.begin != chunk.end)
+    {
+        chunks.push_back(chunk);
+    }
+
+    std::stable_sort(chunks.begin(), chunks.end(), [](Chunk const& a, Chunk const& b)
+    {
+        return a.cost > b.cost;
+    });
+    return chunks;
+}
+
+template<class Formula>
+void CalcFractalByCostBalance<Formula>::calcFractal(std::size_t iterations_count, const Axis& axis,
+                                                    FractalCalcMethod::ResultCallback callbackSetResult)
+{
+    FractalCalcMethod::ConjugateRows rows = FractalCalcMethod::findConjugateRows(axis, Formula::is_conjugate_symmetric);
+    std::vector<Chunk> chunks = makeChunks(iterations_count, axis, rows.computed_rows);
+
+    // The costs of this frame predict the next one
+    int width = axis.screen_borders.x.max;
+    measured_costs.axis = axis;
+    measured_costs.iterations_count = iterations_count;
+    measured_costs.cell_width = cost_cell_size;
+    measured_costs.cell_height = 1;
+    measured_costs.columns = (width + cost_cell_size - 1) / cost_cell_size;
+    measured_costs.rows = axis.screen_borders.y.max;
+    measured_costs.costs.assign(std::size_t(measured_costs.columns) * std::size_t(measured_costs.rows), 0.0);
+
+    auto chunk_task = [this, &axis, &rows, &chunks, iterations_count, callbackSetResult, width](int task)
+    {
+        auto columns = std::size_t(measured_costs.columns);
+        Chunk const& chunk = chunks[std::size_t(task)];
+        for (int row = chunk.begin; row != chunk.end; ++row)
+        {
+            int py = rows.computed_rows[std::size_t(row)];
+            int mirrored_py = rows.mirrored_rows[std::size_t(row)];
+            double* row_costs = &measured_costs.costs[std::size_t(py) * columns];
+            for (int px = 0; px != width; ++px)
+            {
+                Complex c { axis.screenToCartesianX(px), axis.screenToCartesianY(py) };
+                std::size_t spent_iterations = this->calcPoint(iterations_count, c);
+                callbackSetResult(spent_iterations, px, py);
+                if (mirrored_py != -1)
+                {
+                    callbackSetResult(spent_iterations, px, mirrored_py);
+                }
+                row_costs[px / cost_cell_size] += pixelCost(spent_iterations, iterations_count);
+            }
+            for (std::size_t column = 0; column != columns; ++column)
+            {
+                row_costs[column] /= double(std::min(cost_cell_size, width - int(column) * cost_cell_size));
+            }
+            if (mirrored_py != -1)
+            {
+                std::copy(row_costs, row_costs + columns, &measured_costs.costs[std::size_t(mirrored_py) * columns]);
+            }
         }
     };
-    ThreadPoolSimpleInstance::get().addTasks(
-        RowTasksIterator<decltype(row_task)> { row_task, axis.screen_borders.y.max });
-    ThreadPoolSimpleInstance::get().joinMainToWorkers();
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto group_of_task = [&thread_pool, &axis, &rows, &chunks](int task)
+    {
+        int py = rows.computed_rows[std::size_t(chunks[std::size_t(task)].begin)];
+        return thread_pool.groupOfRow(py, axis.screen_borders.y.max);
+    };
+    auto chunks_latch = thread_pool.addTasks(RowTasksIterator<decltype(chunk_task)> { chunk_task, int(chunks.size()) },
+                                             group_of_task);
+    thread_pool.joinMainToWorkers(*chunks_latch);
+    std::swap(previous_costs, measured_costs);
 }
 
-void CalcFractalByPixelsParallel::calcFractal(std::size_t iterations_count, const Axis& axis,
-                                              ResultCallback callbackSetResult)
+template<class Formula>
+void CalcFractalByPixelsParallel<Formula>::calcFractal(std::size_t iterations_count, const Axis& axis,
+                                                       FractalCalcMethod::ResultCallback callbackSetResult)
 {
-    auto pixel_task = [&](int px, int py)
+    auto pixel_task = [&](int py, int px)
     {
         Complex c { axis.screenToCartesianX(px), axis.screenToCartesianY(py) };
-        std::size_t spent_iterations = isInFractalBody(iterations_count, c);
+        std::size_t spent_iterations = this->calcPoint(iterations_count, c);
         callbackSetResult(spent_iterations, px, py);
     };
-    ThreadPoolSimpleInstance::get().addTasks(
-        PixelTasksIterator<decltype(pixel_task)> { pixel_task, axis.screen_borders.y.max, axis.screen_borders.x.max });
-    ThreadPoolSimpleInstance::get().joinMainToWorkers();
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto group_of_task = [&thread_pool, &axis](int task)
+    {
+        return thread_pool.groupOfRow(task / axis.screen_borders.x.max, axis.screen_borders.y.max);
+    };
+    auto pixels_latch = thread_pool.addTasks(
+        PixelTasksIterator<decltype(pixel_task)> { pixel_task, axis.screen_borders.y.max, axis.screen_borders.x.max },
+        group_of_task);
+    thread_pool.joinMainToWorkers(*pixels_latch);
 }
 
-void CalcFractalByPixelsSingleThread::calcFractal(std::size_t iterations_count, const Axis& axis,
-                                                  ResultCallback callbackSetResult)
+template<class Formula>
+void CalcFractalByPixelsSingleThread<Formula>::calcFractal(std::size_t iterations_count, const Axis& axis,
+                                                           FractalCalcMethod::ResultCallback callbackSetResult)
 {
     for (int py = 0; py != axis.screen_borders.y.max; ++py)
     {
         for (int px = 0; px != axis.screen_borders.x.max; ++px)
         {
             Complex c { axis.screenToCartesianX(px), axis.screenToCartesianY(py) };
-            std::size_t spent_iterations = isInFractalBody(iterations_count, c);
+            std::size_t spent_iterations = this->calcPoint(iterations_count, c);
             callbackSetResult(spent_iterations, px, py);
         }
     }
 }
+
+template class CalcFractalByRowsParallel<MandelbrotFormula>;
+template class CalcFractalByRowsParallel<MultibrotFormula<3>>;
+template class CalcFractalByRowsParallel<MultibrotFormula<4>>;
+template class CalcFractalByRowsParallel<BurningShipFormula>;
+template class CalcFractalByRowsParallel<TricornFormula>;
+template class CalcFractalByRowsParallel<JuliaFormula>;
+
+template class CalcFractalByCostBalance<MandelbrotFormula>;
+template class CalcFractalByCostBalance<MultibrotFormula<3>>;
+template class CalcFractalByCostBalance<MultibrotFormula<4>>;
+template class CalcFractalByCostBalance<BurningShipFormula>;
+template class CalcFractalByCostBalance<TricornFormula>;
+template class CalcFractalByCostBalance<JuliaFormula>;
+
+template class CalcFractalByPixelsParallel<MandelbrotFormula>;
+template class CalcFractalByPixelsParallel<MultibrotFormula<3>>;
+template class CalcFractalByPixelsParallel<MultibrotFormula<4>>;
+template class CalcFractalByPixelsParallel<BurningShipFormula>;
+template class CalcFractalByPixelsParallel<TricornFormula>;
+template class CalcFractalByPixelsParallel<JuliaFormula>;
+
+template class CalcFractalByPixelsSingleThread<MandelbrotFormula>;
+template class CalcFractalByPixelsSingleThread<MultibrotFormula<3>>;
+template class CalcFractalByPixelsSingleThread<MultibrotFormula<4>>;
+template class CalcFractalByPixelsSingleThread<BurningShipFormula>;
+template class CalcFractalByPixelsSingleThread<TricornFormula>;
+template class CalcFractalByPixelsSingleThread<JuliaFormula>;
+
+template<std::size_t Limbs>
+void CalcFractalFixedPoint<Limbs>::calcFractal(std::size_t iterations_count, const Axis& axis,
+                                               ResultCallback callbackSetResult)
+{
+    using Fixed = FixedPoint<Limbs>;
+    Fixed x_min = Fixed::fromReal(axis.cartesian_borders.x.min);
+    Fixed y_min = Fixed::fromReal(axis.cartesian_borders.y.min);
+    Fixed x_step = Fixed::fromReal((axis.cartesian_borders.x.max - axis.cartesian_borders.x.min) / axis.screen_borders.x.max);
+    Fixed y_step = Fixed::fromReal((axis.cartesian_borders.y.max - axis.cartesian_borders.y.min) / axis.screen_borders.y.max);
+
+    auto row_task = [&, iterations_count, callbackSetResult](int py)
+    {
+        Fixed c_im = y_min + y_step * unsigned(py);
+        Fixed c_re = x_min;
+        for (int px = 0; px != axis.screen_borders.x.max; ++px)
+        {
+            callbackSetResult(escapeTime(iterations_count, c_re, c_im), px, py);
+            c_re = c_re + x_step;
+        }
+    };
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto group_of_task = [&thread_pool, &axis](int py)
+    {
+        return thread_pool.groupOfRow(py, axis.screen_borders.y.max);
+    };
+    auto rows_latch = thread_pool.addTasks(RowTasksIterator<decltype(row_task)> { row_task, axis.screen_borders.y.max },
+                                           group_of_task);
+    thread_pool.joinMainToWorkers(*rows_latch);
+}
+
+template<std::size_t Limbs>
+std::size_t CalcFractalFixedPoint<Limbs>::calcPoint(std::size_t iterations_count, Complex point) const
+{
+    return escapeTime(iterations_count, FixedPoint<Limbs>::fromReal(point.re), FixedPoint<Limbs>::fromReal(point.im));
+}
+
+template class CalcFractalFixedPoint<2>;
+template class CalcFractalFixedPoint<3>;
+template class CalcFractalFixedPoint<4>;
+
+void CalcFractalMpn::calcFractal(std::size_t iterations_count, const Axis& axis, ResultCallback callbackSetResult)
+{
+    Real x_step = (axis.cartesian_borders.x.max - axis.cartesian_borders.x.min) / axis.screen_borders.x.max;
+    Real y_step = (axis.cartesian_borders.y.max - axis.cartesian_borders.y.min) / axis.screen_borders.y.max;
+    limbs_count = MpnEscapeEngine::limbsForPixelSize(mpf_class(double(std::min(std::abs(x_step), std::abs(y_step)))));
+
+    // The borders are exact in the limbs, their own precision is that of long double
+    MpnFixed x_min = MpnFixed::fromReal(axis.cartesian_borders.x.min, limbs_count);
+    MpnFixed y_min = MpnFixed::fromReal(axis.cartesian_borders.y.min, limbs_count);
+    MpnFixed x_step_fixed = MpnFixed::fromReal(x_step, limbs_count);
+    MpnFixed y_step_fixed = MpnFixed::fromReal(y_step, limbs_count);
+
+    auto row_task = [&, iterations_count, callbackSetResult](int py)
+    {
+        thread_local MpnEscapeEngine engine;
+        engine.setLimbsCount(limbs_count);
+
+        MpnFixed c_im = y_min;
+        engine.addScaledInPlace(c_im, y_step_fixed, unsigned(py));
+        MpnFixed c_re = x_min;
+        for (int px = 0; px != axis.screen_borders.x.max; ++px)
+        {
+            callbackSetResult(engine.escapeTime(iterations_count, c_re, c_im), px, py);
+            engine.addInPlace(c_re, x_step_fixed);
+        }
+    };
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto group_of_task = [&thread_pool, &axis](int py)
+    {
+        return thread_pool.groupOfRow(py, axis.screen_borders.y.max);
+    };
+    auto rows_latch = thread_pool.addTasks(RowTasksIterator<decltype(row_task)> { row_task, axis.screen_borders.y.max },
+                                           group_of_task);
+    thread_pool.joinMainToWorkers(*rows_latch);
+}
+
+std::size_t CalcFractalMpn::calcPoint(std::size_t iterations_count, Complex point) const
+{
+    thread_local MpnEscapeEngine engine;
+    engine.setLimbsCount(limbs_count);
+    return engine.escapeTime(iterations_count, MpnFixed::fromReal(point.re, limbs_count),
+                             MpnFixed::fromReal(point.im, limbs_count));
+}
+
+CalcFractalByPrecisionTier::CalcFractalByPrecisionTier(std::shared_ptr<FractalCalcMethod> shallow_calc_method,
+                                                       std::shared_ptr<FractalCalcMethod> deep_calc_method,
+                                                       Real deep_pixel_size)
+    : shallow_calc_method { std::move(shallow_calc_method) }
+    , deep_calc_method { std::move(deep_calc_method) }
+    , deep_pixel_size { deep_pixel_size }
+{ }
+
+void CalcFractalByPrecisionTier::calcFractal(std::size_t iterations_count, const Axis& axis,
+                                             ResultCallback callbackSetResult)
+{
+    is_deep = axis.pixelSize() < deep_pixel_size;
+    FractalCalcMethod& tier = *(is_deep ? deep_calc_method : shallow_calc_method);
+    PerfPhase phase(tier.name());
+    tier.calcFractal(iterations_count, axis, std::move(callbackSetResult));
+}
+
+std::size_t CalcFractalByPrecisionTier::calcPoint(std::size_t iterations_count, Complex point) const
+{
+    return (is_deep ? deep_calc_method : shallow_calc_method)->calcPoint(iterations_count, point);
+}
+
+FractalCalcMethod const& CalcFractalByPrecisionTier::methodForPixelSize(Real pixel_size) const
+{
+    return pixel_size < deep_pixel_size ? *deep_calc_method : *shallow_calc_method;
+}
+
+std::string CalcFractalByPrecisionTier::name() const
+{
+    return shallow_calc_method->name() + "/" + deep_calc_method->name();
+}
+
+std::string CalcFractalByPrecisionTier::formulaName() const
+{
+    return shallow_calc_method->formulaName();
+}
+
+std::vector<FractalCalcMethod::PixelsShare> CalcFractalByPrecisionTier::lastFramePixelsShares() const
+{
+    return (is_deep ? deep_calc_method : shallow_calc_method)->lastFramePixelsShares();
+}
+
+namespace
+{
+    // The calc methods with a formula policy, nullptr for the others
+    template<class Formula>
+    std::shared_ptr<FractalCalcMethod> makeCalcMethodWithFormula(std::string_view method_name)
+    {
+        if (method_name == "rows")
+        {
+            return std::make_shared<CalcFractalByRowsParallel<Formula>>();
+        }
+        if (method_name == "balanced")
+        {
+            return std::make_shared<CalcFractalByCostBalance<Formula>>();
+        }
+        if (method_name == "pixels")
+        {
+            return std::make_shared<CalcFractalByPixelsParallel<Formula>>();
+        }
+        if (method_name == "single-thread")
+        {
+            return std::make_shared<CalcFractalByPixelsSingleThread<Formula>>();
+        }
+        return nullptr;
+    }
+}
+
+std::shared_ptr<FractalCalcMethod> makeCalcMethodByFormulaName(std::string_view formula_name,
+                                                               std::string_view method_name)
+{
+    std::shared_ptr<FractalCalcMethod> calc_method;
+    if (formula_name == "mandelbrot")
+    {
+        calc_method = makeCalcMethodWithFormula<MandelbrotFormula>(method_name);
+    }
+    else if (formula_name == "multibrot3")
+    {
+        calc_method = makeCalcMethodWithFormula<MultibrotFormula<3>>(method_name);
+    }
+    else if (formula_name == "multibrot4")
+    {
+        calc_method = makeCalcMethodWithFormula<MultibrotFormula<4>>(method_name);
+    }
+    else if (formula_name == "burning-ship")
+    {
+        calc_method = makeCalcMethodWithFormula<BurningShipFormula>(method_name);
+    }
+    else if (formula_name == "tricorn")
+    {
+        calc_method = makeCalcMethodWithFormula<TricornFormula>(method_name);
+    }
+    else if (formula_name == "julia")
+    {
+        calc_method = makeCalcMethodWithFormula<JuliaFormula>(method_name);
+    }
+    else
+    {
+        throw std::invalid_argument("Unknown formula: " + std::string(formula_name));
+    }
+    if (calc_method)
+    {
+        return calc_method;
+    }
+
+    // Throws for an unknown calc method too
+    calc_method = makeCalcMethodByName(method_name);
+    if (formula_name != MandelbrotFormula::name())
+    {
+        throw std::invalid_argument("Calc method " + std::string(method_name) + " computes only the Mandelbrot set, not " +
+                                    std::string(formula_name));
+    }
+    return calc_method;
+}
+
+std::shared_ptr<FractalCalcMethod> makeCalcMethodByName(std::string_view method_name)
+{
+    if (auto calc_method = makeCalcMethodWithFormula<MandelbrotFormula>(method_name))
+    {
+        return calc_method;
+    }
+    if (method_name == "distance-estimation")
+    {
+        return std::make_shared<CalcFractalByDistanceEstimation>();
+    }
+    if (method_name == "fixed128")
+    {
+        return std::make_shared<CalcFractalFixedPoint<2>>();
+    }
+    if (method_name == "fixed192")
+    {
+        return std::make_shared<CalcFractalFixedPoint<3>>();
+    }
+    if (method_name == "fixed256")
+    {
+        return std::make_shared<CalcFractalFixedPoint<4>>();
+    }
+    if (method_name == "mpn")
+    {
+        return std::make_shared<CalcFractalMpn>();
+    }
+    throw std::invalid_argument("Unknown calc method: " + std::string(method_name));
+}
+
+void CalcFractalByDistanceEstimation::calcFractal(std::size_t iterations_count, const Axis& axis,
+                                                  ResultCallback callbackSetResult)
+{
+    interior_filled_pixels = 0;
+    exterior_filled_pixels = 0;
+    int tiles_x = (axis.screen_borders.x.max + tile_size - 1) / tile_size;
+    int tiles_y = (axis.screen_borders.y.max + tile_size - 1) / tile_size;
+
+    auto tile_task = [this, &axis, iterations_count, &callbackSetResult, tiles_x](int tile)
+    {
+        int x = tile % tiles_x * tile_size;
+        int y = tile / tiles_x * tile_size;
+        PlaneBorders<int> block { MinMax<int> { x, std::min(x + tile_size, axis.screen_borders.x.max) },
+                                  MinMax<int> { y, std::min(y + tile_size, axis.screen_borders.y.max) }};
+        calcBlock(iterations_count, axis, callbackSetResult, block);
+    };
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto group_of_task = [&thread_pool, &axis, tiles_x](int tile)
+    {
+        return thread_pool.groupOfRow(tile / tiles_x * tile_size, axis.screen_borders.y.max);
+    };
+    auto tiles_latch = thread_pool.addTasks(RowTasksIterator<decltype(tile_task)> { tile_task, tiles_x * tiles_y },
+                                            group_of_task);
+    thread_pool.joinMainToWorkers(*tiles_latch);
+
+    auto pixels_count = double(axis.screen_borders.x.max) * axis.screen_borders.y.max;
+    last_interior_filled_fraction = double(interior_filled_pixels) / pixels_count;
+    last_exterior_filled_fraction = double(exterior_filled_pixels) / pixels_count;
+}
+
+std::vector<FractalCalcMethod::PixelsShare> CalcFractalByDistanceEstimation::lastFramePixelsShares() const
+{
+    return { PixelsShare { "proven interior, filled without computing", last_interior_filled_fraction },
+             PixelsShare { "approximate exterior, filled by the block center", last_exterior_filled_fraction }};
+}
+
+void CalcFractalByDistanceEstimation::calcBlock(std::size_t iterations_count, const Axis& axis,
+                                                ResultCallback const& callbackSetResult, PlaneBorders<int> block)
+{
+    int width = block.x.max - block.x.min;
+    int height = block.y.max - block.y.min;
+    if (width <= min_block_size || height <= min_block_size)
+    {
+        for (int py = block.y.min; py != block.y.max; ++py)
+        {
+            for (int px = block.x.min; px != block.x.max; ++px)
+            {
+                Complex c { axis.screenToCartesianX(px), axis.screenToCartesianY(py) };
+                callbackSetResult(isInFractalBody(iterations_count, c), px, py);
+            }
+        }
+        return;
+    }
+
+    int center_x = block.x.avg();
+    int center_y = block.y.avg();
+    Complex center { axis.screenToCartesianX(center_x), axis.screenToCartesianY(center_y) };
+    DistanceEstimate estimate = estimateDistance(iterations_count, center);
+
+    // Farthest pixel of the block is one of the corners
+    Real radius = std::hypot(
+        std::max(center_x - block.x.min, block.x.max - 1 - center_x) * std::abs(axis.screenToCartesianX(1) - axis.screenToCartesianX(0)),
+        std::max(center_y - block.y.min, block.y.max - 1 - center_y) * std::abs(axis.screenToCartesianY(1) - axis.screenToCartesianY(0)));
+
+    if (estimate.is_interior && estimate.interior_distance > radius)
+    {
+        for (int py = block.y.min; py != block.y.max; ++py)
+        {
+            for (int px = block.x.min; px != block.x.max; ++px)
+            {
+                callbackSetResult(std::numeric_limits<std::size_t>::max(), px, py);
+            }
+        }
+        interior_filled_pixels += std::size_t(width) * std::size_t(height) - 1;
+        return;
+    }
+
+    // Out of the set is not enough: the escape band must be the same over the block too
+    auto escapesWithCenter = [&](int px, int py)
+    {
+        Complex c { axis.screenToCartesianX(px), axis.screenToCartesianY(py) };
+        return isInFractalBody(iterations_count, c) == estimate.spent_iterations;
+    };
+    bool is_uniform = estimate.exterior_distance > radius &&
+                      escapesWithCenter(block.x.min, block.y.min) && escapesWithCenter(block.x.max - 1, block.y.min) &&
+                      escapesWithCenter(block.x.min, block.y.max - 1) && escapesWithCenter(block.x.max - 1, block.y.max - 1);
+
+    if (is_uniform)
+    {
+        for (int py = block.y.min; py != block.y.max; ++py)
+        {
+            for (int px = block.x.min; px != block.x.max; ++px)
+            {
+                callbackSetResult(estimate.spent_iterations, px, py);
+            }
+        }
+        // The center and the corners are computed
+        exterior_filled_pixels += std::size_t(width) * std::size_t(height) - 5;
+        return;
+    }
+
+    PlaneBorders<int> quadrants[] = {
+        { MinMax<int> { block.x.min, center_x }, MinMax<int> { block.y.min, center_y }},
+        { MinMax<int> { center_x, block.x.max }, MinMax<int> { block.y.min, center_y }},
+        { MinMax<int> { block.x.min, center_x }, MinMax<int> { center_y, block.y.max }},
+        { MinMax<int> { center_x, block.x.max }, MinMax<int> { center_y, block.y.max }}
+    };
+    for (PlaneBorders<int> const& quadrant: quadrants)
+    {
+        calcBlock(iterations_count, axis, callbackSetResult, quadrant);
+    }
+}
@@ -1,36 +1,346 @@
 #ifndef MANDELBROT_CPP_FRACTALCALCMETHODS_H
 #define MANDELBROT_CPP_FRACTALCALCMETHODS_H
 
+#include <algorithm>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "../Multithreading/ThreadPool.h"
 #include "../Utility/Types.h"
+#include "FractalFormulas.h"
 
 class FractalCalcMethod
 {
 public:
     using ResultCallback = std::function<void(std::size_t spent_iterations, int px, int py)>;
 
-    [[nodiscard]] static std::size_t isInFractalBody(std::size_t iterations_count, Complex c) ;
+    struct DistanceEstimate
+    {
+        std::size_t spent_iterations;
+
+        // Lower bound of the distance from c to the set. Zero when c is not escaped
+        Real exterior_distance;
+
+        // The orbit is caught by an attracting cycle, so c is in the set
+        bool is_interior = false;
+
+        // Lower bound of the distance from an interior c to the boundary of the set
+        Real interior_distance = 0;
+    };
+
+    template<class Formula = MandelbrotFormula>
+    [[nodiscard]] static std::size_t isInFractalBody(std::size_t iterations_count, Complex point,
+                                                     Formula const& formula = { });
+
+    // Rows to compute and, in parallel, the row each of them fills too (-1 if none).
+    // Rows pair up when their imaginary parts are exact negatives, so the mirrored result is bit-identical.
+    // Rows of different thread groups don't pair, so each row is written by the group that owns it
+    struct ConjugateRows
+    {
+        std::vector<int> computed_rows;
+        std::vector<int> mirrored_rows;
+    };
+
+    [[nodiscard]] static ConjugateRows findConjugateRows(const Axis& axis, bool is_conjugate_symmetric);
+
+    // Tracks dz/dc for the exterior distance. A bounded orbit that returns near an earlier point is checked
+    // for an attracting cycle of that period, which proves c interior and gives the interior distance.
+    // Other points that don't escape run the whole iterations count
+    [[nodiscard]] static DistanceEstimate estimateDistance(std::size_t iterations_count, Complex c);
+
+    // Single point by the formula of the calc method
+    [[nodiscard]] virtual std::size_t calcPoint(std::size_t iterations_count, Complex point) const;
+
+    // The calc method whose calcPoint suits points sampled pixel_size apart: itself, or a tier of a tiered one
+    [[nodiscard]] virtual FractalCalcMethod const& methodForPixelSize(Real pixel_size) const;
+
     virtual void calcFractal(std::size_t iterations_count, const Axis& axis, ResultCallback callbackSetResult) = 0;
+
+    // As makeCalcMethodByName takes it
+    [[nodiscard]] virtual std::string name() const = 0;
+
+    // As makeCalcMethodByFormulaName takes it, the methods without a formula policy compute the Mandelbrot set
+    [[nodiscard]] virtual std::string formulaName() const;
+
+    struct PixelsShare
+    {
+        std::string label;
+        double fraction;
+    };
+
+    // Shares of the pixels of the last frame that were produced other than by computing them.
+    // Empty for the methods that compute every pixel
+    [[nodiscard]] virtual std::vector<PixelsShare> lastFramePixelsShares() const;
+
+    virtual ~FractalCalcMethod() = default;
+};
+
+template<class Formula>
+std::size_t FractalCalcMethod::isInFractalBody(std::size_t iterations_count, Complex point, Formula const& formula)
+{
+    Complex z = formula.initialZ(point);
+    Complex c = formula.constant(point);
+
+    for (std::size_t i = 0; i != iterations_count; ++i)
+    {
+        z = formula.step(z, c);
+
+        // Math theorem.
+        // For any point in the complex plane, we assign a value to k and iterate.
+        // if at any particular moment of calculations, for k, the distance from zi(k) to the origin
+        // is greater than 2, then we can assume that the given {Zn(k)} will go to infinity
+        // (In comparison: the distance is 2, so its square is less than 4 and the square root no need to calcFractal)
+        if (z.re * z.re + z.im * z.im > 4)
+        {
+            return i;
+        }
+    }
+
+    return std::numeric_limits<std::size_t>::max();
+}
+
+// Keeps the formula of the calc method. Per-frame dispatch stays virtual, per-pixel work is inlined
+template<class Formula>
+class FractalCalcMethodWithFormula: public FractalCalcMethod
+{
+public:
+    explicit FractalCalcMethodWithFormula(Formula formula = { })
+        : formula(formula)
+    { }
+
+    // Final, so the per-pixel calls of the derived calc methods are not virtual
+    [[nodiscard]] std::size_t calcPoint(std::size_t iterations_count, Complex point) const final
+    {
+        return isInFractalBody(iterations_count, point, formula);
+    }
+
+    [[nodiscard]] std::string formulaName() const override
+    {
+        return Formula::name();
+    }
+
+protected:
+    Formula formula;
 };
 
-class CalcFractalByRowsParallel: public FractalCalcMethod
+template<class Formula = MandelbrotFormula>
+class CalcFractalByRowsParallel: public FractalCalcMethodWithFormula<Formula>
+{
+public:
+    // A task computes rows_per_task adjacent rows
+    explicit CalcFractalByRowsParallel(Formula formula = { }, int rows_per_task = 1)
+        : FractalCalcMethodWithFormula<Formula>(formula)
+        , rows_per_task(std::max(rows_per_task, 1))
+    { }
+
+    void calcFractal(std::size_t iterations_count, const Axis &axis,
+                     FractalCalcMethod::ResultCallback callbackSetResult) override;
+
+    [[nodiscard]] std::string name() const override
+    {
+        return "rows";
+    }
+
+private:
+    int rows_per_task;
+};
+
+// Rows-parallel with the cost of the rows predicted from the previous frame at the same cartesian position,
+// or from a coarse pre-pass when the view moved too far. Rows are grouped into chunks by the predicted cost,
+// the most expensive chunks are queued first and the cheap ones even out the end of the frame
+template<class Formula = MandelbrotFormula>
+class CalcFractalByCostBalance: public FractalCalcMethodWithFormula<Formula>
+{
+public:
+    using FractalCalcMethodWithFormula<Formula>::FractalCalcMethodWithFormula;
+
+    void calcFractal(std::size_t iterations_count, const Axis &axis,
+                     FractalCalcMethod::ResultCallback callbackSetResult) override;
+
+    [[nodiscard]] std::string name() const override
+    {
+        return "balanced";
+    }
+
+private:
+    // Mean iterations per pixel over cells of cell_width x cell_height pixels of the measured frame
+    struct CostMap
+    {
+        Axis axis = { PlaneBorders<Real> { MinMax<Real> { 0, 1 }, MinMax<Real> { 0, 1 }},
+                      PlaneBorders<int> { MinMax<int> { 0, 1 }, MinMax<int> { 0, 1 }}};
+        std::size_t iterations_count = 0;
+        int cell_width = 1;
+        int cell_height = 1;
+        int columns = 0;
+        int rows = 0;
+        std::vector<double> costs;
+
+        [[nodiscard]] double costAt(Real x, Real y) const;
+
+        // Fraction of the view that the map covers
+        [[nodiscard]] double coverage(Axis const& view) const;
+    };
+
+    struct Chunk
+    {
+        int begin;
+        int end;
+        double cost;
+    };
+
+    // Samples the center of every coarse_cell_size square on the thread pool
+    CostMap measureCoarseCosts(std::size_t iterations_count, Axis const& axis) const;
+
+    [[nodiscard]] std::vector<Chunk> makeChunks(std::size_t iterations_count, Axis const& axis,
+                                                std::vector<int> const& computed_rows) const;
+
+private:
+    static constexpr int cost_cell_size = 16;
+    static constexpr int coarse_cell_size = 8;
+    static constexpr double smallest_chunk_share = 1.0 / 64;
+    static constexpr double min_coverage = 0.5;
+
+    CostMap previous_costs;
+    CostMap measured_costs;
+};
+
+template<class Formula = MandelbrotFormula>
+class CalcFractalByPixelsParallel: public FractalCalcMethodWithFormula<Formula>
+{
+public:
+    using FractalCalcMethodWithFormula<Formula>::FractalCalcMethodWithFormula;
+
+    void calcFractal(std::size_t iterations_count, const Axis &axis,
+                     FractalCalcMethod::ResultCallback callbackSetResult) override;
+
+    [[nodiscard]] std::string name() const override
+    {
+        return "pixels";
+    }
+};
+
+template<class Formula = MandelbrotFormula>
+class CalcFractalByPixelsSingleThread: public FractalCalcMethodWithFormula<Formula>
+{
+public:
+    using FractalCalcMethodWithFormula<Formula>::FractalCalcMethodWithFormula;
+
+    void calcFractal(std::size_t iterations_count, const Axis &axis,
+                     FractalCalcMethod::ResultCallback callbackSetResult) override;
+
+    [[nodiscard]] std::string name() const override
+    {
+        return "single-thread";
+    }
+};
+
+// Splits the screen into tiles and each tile recursively into quadrants.
+// A block whose center is farther inside the set than the block radius is proven to be in the set and filled as the set.
+// A block whose center is farther from the set than the block radius and whose corners escape on the same
+// iteration as its center is filled by the escape time of the center. The distance proves only that the block
+// is out of the set, so these exterior fills are approximate: a few pixels may escape on another iteration
+class CalcFractalByDistanceEstimation: public FractalCalcMethod
 {
 public:
     void calcFractal(std::size_t iterations_count, const Axis &axis, ResultCallback callbackSetResult) override;
+
+    [[nodiscard]] std::string name() const override
+    {
+        return "distance-estimation";
+    }
+
+    [[nodiscard]] std::vector<PixelsShare> lastFramePixelsShares() const override;
+
+private:
+    void calcBlock(std::size_t iterations_count, const Axis& axis, ResultCallback const& callbackSetResult,
+                   PlaneBorders<int> block);
+
+private:
+    static constexpr int tile_size = 64;
+    static constexpr int min_block_size = 4;
+    std::atomic<std::size_t> interior_filled_pixels = 0;
+    std::atomic<std::size_t> exterior_filled_pixels = 0;
+    double last_interior_filled_fraction = 0;
+    double last_exterior_filled_fraction = 0;
+};
+
+
+// Rows-parallel Mandelbrot on fixed-point numbers of Limbs 64-bit words.
+// Pixel positions are accumulated in fixed point, the view borders come from the long double axis
+template<std::size_t Limbs>
+class CalcFractalFixedPoint: public FractalCalcMethod
+{
+public:
+    void calcFractal(std::size_t iterations_count, const Axis &axis, ResultCallback callbackSetResult) override;
+
+    [[nodiscard]] std::size_t calcPoint(std::size_t iterations_count, Complex point) const override;
+
+    [[nodiscard]] std::string name() const override
+    {
+        return "fixed" + std::to_string(Limbs * 64);
+    }
 };
 
-class CalcFractalByPixelsParallel: public FractalCalcMethod
+// Rows-parallel Mandelbrot on MpnEscapeEngine, one engine per thread.
+// The count of limbs follows the pixel size of the view. As with the fixed-point methods, the view borders come
+// from the long double axis: the depth is capped where its width is no longer many ulps of its borders (about
+// 2^-64 relative to them), deeper the extra limbs only keep the orbits of the quantized points exact
+class CalcFractalMpn: public FractalCalcMethod
 {
 public:
     void calcFractal(std::size_t iterations_count, const Axis &axis, ResultCallback callbackSetResult) override;
+
+    [[nodiscard]] std::size_t calcPoint(std::size_t iterations_count, Complex point) const override;
+
+    [[nodiscard]] std::string name() const override
+    {
+        return "mpn";
+    }
+
+private:
+    std::size_t limbs_count = 2;
 };
 
-class CalcFractalByPixelsSingleThread: public FractalCalcMethod
+// Shallow calc method while a pixel is not smaller than deep_pixel_size, deep one after
+class CalcFractalByPrecisionTier: public FractalCalcMethod
 {
 public:
+    CalcFractalByPrecisionTier(std::shared_ptr<FractalCalcMethod> shallow_calc_method,
+                               std::shared_ptr<FractalCalcMethod> deep_calc_method, Real deep_pixel_size);
+
+    // The tier of the frame is profiled as a phase of its own name
     void calcFractal(std::size_t iterations_count, const Axis &axis, ResultCallback callbackSetResult) override;
+
+    // By the tier of the last frame
+    [[nodiscard]] std::size_t calcPoint(std::size_t iterations_count, Complex point) const override;
+
+    [[nodiscard]] FractalCalcMethod const& methodForPixelSize(Real pixel_size) const override;
+
+    // "shallow/deep"
+    [[nodiscard]] std::string name() const override;
+
+    [[nodiscard]] std::string formulaName() const override;
+
+    // Of the tier of the last frame
+    [[nodiscard]] std::vector<PixelsShare> lastFramePixelsShares() const override;
+
+private:
+    std::shared_ptr<FractalCalcMethod> shallow_calc_method;
+    std::shared_ptr<FractalCalcMethod> deep_calc_method;
+    Real deep_pixel_size;
+    bool is_deep = false;
 };
 
+// Calc method for "mandelbrot", "multibrot3", "multibrot4", "burning-ship", "tricorn" or "julia".
+// "rows", "balanced", "pixels" and "single-thread" take any formula, the other calc methods only "mandelbrot"
+std::shared_ptr<FractalCalcMethod> makeCalcMethodByFormulaName(std::string_view formula_name,
+                                                               std::string_view method_name = "rows");
+
+// Mandelbrot calc method "rows", "balanced", "pixels", "single-thread", "distance-estimation", "fixed128", "fixed192", "fixed256" or "mpn"
+std::shared_ptr<FractalCalcMethod> makeCalcMethodByName(std::string_view method_name);
 
 #endif //MANDELBROT_CPP_FRACTALCALCMETHODS_H
@@ -0,0 +1,154 @@
+#ifndef MANDELBROT_CPP_FRACTALFORMULAS_H
+#define MANDELBROT_CPP_FRACTALFORMULAS_H
+
+#include <cmath>
+#include <string>
+#include "../Utility/Types.h"
+
+// Escape-time formulas z(n+1) = f(z(n), c) as compile-time policies.
+// initialZ() and constant() map the pixel point to the start of the orbit and to c.
+// Every policy is a template argument of the calc methods, so each one gets its own inlined inner loop.
+// is_conjugate_symmetric: the orbit of conj(c) is the conjugate of the orbit of c, rounding included.
+// name() is the formula as makeCalcMethodByFormulaName takes it
+
+struct MandelbrotFormula
+{
+    static constexpr bool is_conjugate_symmetric = true;
+
+    [[nodiscard]] static std::string name()
+    {
+        return "mandelbrot";
+    }
+
+    [[nodiscard]] static Complex initialZ(Complex)
+    {
+        return { 0, 0 };
+    }
+
+    [[nodiscard]] static Complex constant(Complex point)
+    {
+        return point;
+    }
+
+    // z*z + c
+    [[nodiscard]] static Complex step(Complex z, Complex c)
+    {
+        return { z.re * z.re - z.im * z.im + c.re, 2 * z.re * z.im + c.im };
+    }
+};
+
+template<int Degree>
+struct MultibrotFormula
+{
+    static_assert(Degree >= 2, "Multibrot degree must be at least 2");
+
+    static constexpr bool is_conjugate_symmetric = true;
+
+    [[nodiscard]] static std::string name()
+    {
+        return "multibrot" + std::to_string(Degree);
+    }
+
+    [[nodiscard]] static Complex initialZ(Complex)
+    {
+        return { 0, 0 };
+    }
+
+    [[nodiscard]] static Complex constant(Complex point)
+    {
+        return point;
+    }
+
+    // z^Degree + c, the power loop is unrolled by the compiler
+    [[nodiscard]] static Complex step(Complex z, Complex c)
+    {
+        Complex power = z;
+        for (int i = 1; i != Degree; ++i)
+        {
+            power = Complex { power.re * z.re - power.im * z.im, power.re * z.im + power.im * z.re };
+        }
+        return { power.re + c.re, power.im + c.im };
+    }
+};
+
+struct BurningShipFormula
+{
+    static constexpr bool is_conjugate_symmetric = false;
+
+    [[nodiscard]] static std::string name()
+    {
+        return "burning-ship";
+    }
+
+    [[nodiscard]] static Complex initialZ(Complex)
+    {
+        return { 0, 0 };
+    }
+
+    [[nodiscard]] static Complex constant(Complex point)
+    {
+        return point;
+    }
+
+    // (|re| + i|im|)^2 + c
+    [[nodiscard]] static Complex step(Complex z, Complex c)
+    {
+        return { z.re * z.re - z.im * z.im + c.re, 2 * std::abs(z.re * z.im) + c.im };
+    }
+};
+
+struct TricornFormula
+{
+    static constexpr bool is_conjugate_symmetric = true;
+
+    [[nodiscard]] static std::string name()
+    {
+        return "tricorn";
+    }
+
+    [[nodiscard]] static Complex initialZ(Complex)
+    {
+        return { 0, 0 };
+    }
+
+    [[nodiscard]] static Complex constant(Complex point)
+    {
+        return point;
+    }
+
+    // conj(z)^2 + c
+    [[nodiscard]] static Complex step(Complex z, Complex c)
+    {
+        return { z.re * z.re - z.im * z.im + c.re, -2 * z.re * z.im + c.im };
+    }
+};
+
+// The pixel is the start of the orbit, c is fixed for the whole image
+struct JuliaFormula
+{
+    static constexpr bool is_conjugate_symmetric = false;
+
+    [[nodiscard]] static std::string name()
+    {
+        return "julia";
+    }
+
+    [[nodiscard]] static Complex initialZ(Complex point)
+    {
+        return point;
+    }
+
+    [[nodiscard]] Complex constant(Complex) const
+    {
+        return c;
+    }
+
+    [[nodiscard]] static Complex step(Complex z, Complex c)
+    {
+        return MandelbrotFormula::step(z, c);
+    }
+
+    Complex c = { -0.8L, 0.156L };
+};
+
+#endif //MANDELBROT_CPP_FRACTALFORMULAS_H
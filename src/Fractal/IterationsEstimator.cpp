@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <atomic>
+#include "IterationsEstimator.h"
+#include "TaskIterators.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+
+namespace
+{
+    constexpr std::size_t not_escaped = std::numeric_limits<std::size_t>::max();
+
+    // Iterations a pixel costs with the given limit
+    std::size_t pixelCost(std::size_t escape_time, std::size_t iterations_count)
+    {
+        return escape_time == not_escaped ? iterations_count : std::min(escape_time, iterations_count);
+    }
+}
+
+IterationsEstimator::IterationsEstimator(MinMax<int> iterations_limit)
+    : iterations_limit { iterations_limit }
+    , escape_times(std::size_t(grid_width) * grid_height)
+{ }
+
+IterationsEstimate IterationsEstimator::estimate(FractalCalcMethod const& calc_method, Axis const& axis,
+                                                 int baseline_iterations_count)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    std::fill(escape_times.begin(), escape_times.end(), not_escaped);
+    std::atomic<std::size_t> sampled_iterations = 0;
+    std::size_t escaped_count = 0;
+    auto cap = std::size_t(iterations_limit.min);
+
+    // The tier the frame of the view is computed by, not the tier of the previous frame
+    FractalCalcMethod const& view_calc_method = calc_method.methodForPixelSize(axis.pixelSize());
+
+    while (true)
+    {
+        // Only the samples not escaped yet are iterated with the raised limit
+        auto sample_row_task = [&](int gy)
+        {
+            std::size_t row_iterations = 0;
+            for (int gx = 0; gx != grid_width; ++gx)
+            {
+                std::size_t& escape_time = escape_times[std::size_t(gy) * grid_width + std::size_t(gx)];
+                if (escape_time != not_escaped)
+                {
+                    continue;
+                }
+                int px = (2 * gx + 1) * axis.screen_borders.x.max / (2 * grid_width);
+                int py = (2 * gy + 1) * axis.screen_borders.y.max / (2 * grid_height);
+                escape_time = view_calc_method.calcPoint(cap, Complex { axis.screenToCartesianX(px),
+                                                                        axis.screenToCartesianY(py) });
+                row_iterations += pixelCost(escape_time, cap);
+            }
+            sampled_iterations += row_iterations;
+        };
+        auto& thread_pool = ThreadPoolSimpleInstance::get();
+        auto samples_latch = thread_pool.addTasks(RowTasksIterator<decltype(sample_row_task)> { sample_row_task, grid_height });
+        thread_pool.joinMainToWorkers(*samples_latch);
+
+        auto cap_escaped_count = std::size_t(std::count_if(escape_times.begin(), escape_times.end(),
+                                                           [](std::size_t t) { return t != not_escaped; }));
+        bool is_saturated = escaped_count != 0 &&
+                            double(cap_escaped_count - escaped_count) <= saturation_fraction * double(escape_times.size());
+        escaped_count = cap_escaped_count;
+        if (is_saturated || cap >= std::size_t(iterations_limit.max))
+        {
+            break;
+        }
+        cap = std::min(cap * 2, std::size_t(iterations_limit.max));
+    }
+
+    std::size_t longest_escape = 0;
+    for (std::size_t escape_time: escape_times)
+    {
+        if (escape_time != not_escaped)
+        {
+            longest_escape = std::max(longest_escape, escape_time);
+        }
+    }
+    int iterations_count = iterations_limit.clamp(int(double(longest_escape) * iterations_margin));
+    std::chrono::duration<double, std::milli> sampling_time = std::chrono::steady_clock::now() - begin;
+
+    // Sampling gives the cost of one iteration, the samples give the cost difference per pixel
+    std::size_t baseline_cost = 0;
+    std::size_t chosen_cost = 0;
+    for (std::size_t escape_time: escape_times)
+    {
+        baseline_cost += pixelCost(escape_time, std::size_t(baseline_iterations_count));
+        chosen_cost += pixelCost(escape_time, std::size_t(iterations_count));
+    }
+    double pixels_per_sample = double(axis.screen_borders.x.max) * axis.screen_borders.y.max / double(escape_times.size());
+    double ms_per_iteration = sampling_time.count() / double(std::max<std::size_t>(sampled_iterations, 1));
+    double saved_ms = (double(baseline_cost) - double(chosen_cost)) * pixels_per_sample * ms_per_iteration;
+
+    return { iterations_count, sampling_time, std::chrono::duration<double, std::milli>(saved_ms) };
+}
@@ -0,0 +1,36 @@
+#ifndef MANDELBROT_CPP_ITERATIONSESTIMATOR_H
+#define MANDELBROT_CPP_ITERATIONSESTIMATOR_H
+
+#include <chrono>
+#include "FractalCalcMethods.h"
+
+struct IterationsEstimate
+{
+    int iterations_count;
+    std::chrono::duration<double, std::milli> sampling_time;
+
+    // Predicted full-frame time saved against rendering with the baseline iterations count
+    std::chrono::duration<double, std::milli> saved_time;
+};
+
+// Samples a sparse grid of the view with a doubling iterations limit.
+// When doubling the limit lets almost no new samples escape, the escape-time histogram is saturated:
+// the longest escape seen so far (with a margin) becomes the iterations count of the full render
+class IterationsEstimator
+{
+public:
+    explicit IterationsEstimator(MinMax<int> iterations_limit);
+
+    IterationsEstimate estimate(FractalCalcMethod const& calc_method, Axis const& axis, int baseline_iterations_count);
+
+private:
+    static constexpr int grid_width = 48;
+    static constexpr int grid_height = 36;
+    static constexpr double saturation_fraction = 0.001;
+    static constexpr double iterations_margin = 1.25;
+
+    MinMax<int> iterations_limit;
+    std::vector<std::size_t> escape_times;
+};
+
+#endif //MANDELBROT_CPP_ITERATIONSESTIMATOR_H
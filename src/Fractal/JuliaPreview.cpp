@@ -0,0 +1,187 @@
+#include <algorithm>
+#include "JuliaPreview.h"
+#include "FractalCalcMethods.h"
+#include "TaskIterators.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+
+namespace
+{
+    constexpr float panel_margin = 10;
+}
+
+JuliaPreview::JuliaPreview(const ProgramConfig& program_config)
+    : config { program_config.julia_preview_config }
+    , color_table { program_config.color_table_config }
+{
+    unsigned max_resolution = unsigned(std::end(levels)[-1].resolution);
+    pixels.resize(std::size_t(max_resolution) * max_resolution * 4);
+    texture.create(max_resolution, max_resolution);
+    sprite.setTexture(texture);
+    sprite.setPosition(float(program_config.window_mode.width - config.panel_size) - panel_margin, panel_margin);
+}
+
+JuliaPreview::~JuliaPreview()
+{
+    // Row tasks write into this object
+    if (rows_latch)
+    {
+        rows_latch->wait();
+    }
+}
+
+bool JuliaPreview::update(Complex cursor_point)
+{
+    if (!config.is_enabled)
+    {
+        return false;
+    }
+
+    bool is_image_updated = collectFinishedRows();
+    if (rows_latch)
+    {
+        return is_image_updated;
+    }
+
+    if (cursor_point != target_c)
+    {
+        target_c = cursor_point;
+        target_level = bestLevelInBudget();
+        next_row = 0;
+        is_target_finished = false;
+        last_cursor_move = Clock::now();
+    }
+    else if (is_target_finished && target_level + 1 != std::size(levels) &&
+             Clock::now() - last_cursor_move >= config.cursor_rest_time)
+    {
+        ++target_level;
+        next_row = 0;
+        is_target_finished = false;
+    }
+
+    if (!is_target_finished)
+    {
+        submitRows();
+    }
+    return is_image_updated;
+}
+
+void JuliaPreview::toggle()
+{
+    config.is_enabled = !config.is_enabled;
+}
+
+bool JuliaPreview::isBusy() const
+{
+    return config.is_enabled && (rows_latch || !is_target_finished || target_level + 1 != std::size(levels));
+}
+
+void JuliaPreview::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    if (config.is_enabled && is_shown)
+    {
+        target.draw(sprite, states);
+    }
+}
+
+bool JuliaPreview::collectFinishedRows()
+{
+    if (!rows_latch || !rows_latch->isReleased())
+    {
+        return false;
+    }
+    rows_latch.reset();
+
+    Level level = levels[target_level];
+    double pixel_iterations = double(rows_in_flight) * level.resolution * double(level.iterations_count);
+    double measured_ns = double(rows_compute_ns) / pixel_iterations;
+    ns_per_pixel_iteration = ns_per_pixel_iteration == 0
+                             ? measured_ns
+                             : 0.7 * ns_per_pixel_iteration + 0.3 * measured_ns;
+
+    if (next_row != level.resolution)
+    {
+        return false;
+    }
+
+    auto resolution = unsigned(level.resolution);
+    texture.update(pixels.data(), resolution, resolution, 0, 0);
+    sprite.setTextureRect(sf::IntRect(0, 0, level.resolution, level.resolution));
+    float scale = float(config.panel_size) / float(resolution);
+    sprite.setScale(scale, scale);
+    is_shown = true;
+    is_target_finished = true;
+    return true;
+}
+
+void JuliaPreview::submitRows()
+{
+    Level level = levels[target_level];
+    double row_ns = predictLevelNs(level) / level.resolution;
+    double budget_ns = std::chrono::duration<double, std::nano>(config.frame_budget).count();
+
+    int rows_count = level.resolution - next_row;
+    if (row_ns > 0)
+    {
+        rows_count = std::clamp(int(budget_ns / row_ns), 1, rows_count);
+    }
+
+    auto row_task = [this, c = target_c, level, first_row = next_row](int row)
+    {
+        calcRow(c, level, first_row + row);
+    };
+    rows_compute_ns = 0;
+    rows_in_flight = std::size_t(rows_count);
+    next_row += rows_count;
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    rows_latch = thread_pool.addTasks(RowTasksIterator<decltype(row_task)> { row_task, rows_count });
+    if (thread_pool.threadsCount() == 1)
+    {
+        // No workers: the rows are computed right here, still within the budget
+        thread_pool.joinMainToWorkers(*rows_latch);
+    }
+}
+
+void JuliaPreview::calcRow(Complex c, Level level, int py)
+{
+    auto begin = Clock::now();
+
+    JuliaFormula formula { c };
+    MinMax<int> screen_range { 0, level.resolution };
+    MinMax<Real> plane_range { -half_plane_size, half_plane_size };
+    Real y = screen_range.lerp(py, plane_range);
+
+    for (int px = 0; px != level.resolution; ++px)
+    {
+        Complex z0 { screen_range.lerp(px, plane_range), y };
+        std::size_t spent_iterations = FractalCalcMethod::isInFractalBody(level.iterations_count, z0, formula);
+
+        sf::Color color = color_table.colorOf(spent_iterations);
+        sf::Uint8* pixel = &pixels[(std::size_t(py) * std::size_t(level.resolution) + std::size_t(px)) * 4];
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
+        pixel[3] = color.a;
+    }
+
+    rows_compute_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+}
+
+double JuliaPreview::predictLevelNs(Level level) const
+{
+    double pixel_iterations = double(level.resolution) * level.resolution * double(level.iterations_count);
+    return ns_per_pixel_iteration * pixel_iterations / double(ThreadPoolSimpleInstance::get().threadsCount());
+}
+
+std::size_t JuliaPreview::bestLevelInBudget() const
+{
+    double budget_ns = std::chrono::duration<double, std::nano>(config.frame_budget).count();
+    std::size_t best_level = 0;
+    for (std::size_t level = 1; level != std::size(levels); ++level)
+    {
+        if (ns_per_pixel_iteration != 0 && predictLevelNs(levels[level]) <= budget_ns)
+        {
+            best_level = level;
+        }
+    }
+    return best_level;
+}
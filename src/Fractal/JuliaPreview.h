@@ -0,0 +1,73 @@
+#ifndef MANDELBROT_CPP_JULIAPREVIEW_H
+#define MANDELBROT_CPP_JULIAPREVIEW_H
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <atomic>
+#include "../Multithreading/CompletionLatch.h"
+#include "Config.h"
+#include "ColorTable.h"
+
+// Side panel with the Julia set of the point under the cursor.
+// Rows are rendered on the thread pool without waiting for them: every frame gets at most
+// the frame budget of new work, so the Mandelbrot view never stalls behind the preview.
+// A moving cursor gets the best level that fits into one budget, a resting cursor refines the level
+class JuliaPreview : public sf::Drawable
+{
+public:
+    explicit JuliaPreview(const ProgramConfig& program_config);
+    ~JuliaPreview() override;
+
+    // True when the panel got a new image
+    bool update(Complex cursor_point);
+
+    void toggle();
+
+    // Rows are in flight or the preview is refining: the caller should keep updating
+    [[nodiscard]] bool isBusy() const;
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+    struct Level
+    {
+        int resolution;
+        std::size_t iterations_count;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    bool collectFinishedRows();
+    void submitRows();
+    void calcRow(Complex c, Level level, int py);
+
+    [[nodiscard]] double predictLevelNs(Level level) const;
+    [[nodiscard]] std::size_t bestLevelInBudget() const;
+
+private:
+    static constexpr Level levels[] = { { 32, 64 }, { 64, 128 }, { 128, 256 }, { 256, 512 } };
+    static constexpr Real half_plane_size = 1.6L;
+
+    JuliaPreviewConfig config;
+    ColorTable color_table;
+
+    std::vector<sf::Uint8> pixels;
+    sf::Texture texture;
+    sf::Sprite sprite;
+    bool is_shown = false;
+
+    Complex target_c = { 0, 0 };
+    std::size_t target_level = 0;
+    int next_row = 0;
+    bool is_target_finished = false;
+    Clock::time_point last_cursor_move;
+
+    std::shared_ptr<CompletionLatch> rows_latch;
+    std::size_t rows_in_flight = 0;
+    std::atomic<long long> rows_compute_ns = 0;
+
+    // Cost model: nanoseconds per pixel per iteration limit, measured on the finished rows
+    double ns_per_pixel_iteration = 0;
+};
+
+#endif //MANDELBROT_CPP_JULIAPREVIEW_H
@@ -1,33 +1,119 @@
+#include <algorithm>
 #include <limits>
 #include <iostream>
+#include <format>
+#include <atomic>
 #include "MandelbrotFractal.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+#include "../Multithreading/PerfProfiler.h"
 
 
 MandelbrotFractal::MandelbrotFractal(const ProgramConfig& program_config)
-    : current_iterations_count { program_config.iterations_limit.min }
+    : width { program_config.window_mode.width }
+    , height { program_config.window_mode.height }
+    , current_iterations_count { program_config.iterations_limit.min }
     , limit_iterations { program_config.iterations_limit }
+    , is_auto_iterations { program_config.is_auto_iterations }
+    , iterations_estimator { program_config.iterations_limit }
+    , color_table { program_config.color_table_config }
     , calc_method { program_config.calc_method }
 {
-    fractal_image.image.create(program_config.window_mode.width, program_config.window_mode.height);
-    color_table.resize(program_config.color_table_config.transition_color_smoothness);
+    fractal_image.create(width, height);
 
-    MinMax<std::size_t> color_table_index_range = {
-        0, std::size(color_table) / program_config.color_table_config.transition_colors_count
-    };
-
-    for (std::size_t i = 0; i != std::size(color_table); ++i)
-    {
-        color_table[i] = color_table_index_range.lerp(i, program_config.color_table_config.color_range);
-    }
+    // Escape times are left untouched when the workers do the first write: the OS places each page on the NUMA node
+    // of the worker that computes it. The calc methods run each row on the thread group of its node every frame
+    std::size_t pixels_count = std::size_t(width) * height;
+    escape_times = program_config.is_first_touch_image_buffer
+                   ? std::unique_ptr<std::size_t[]>(new std::size_t[pixels_count])
+                   : std::make_unique<std::size_t[]>(pixels_count);
+    rows_progress = std::make_unique<RowProgress[]>(height);
 }
+
 void MandelbrotFractal::update(const Axis& axis)
 {
-    auto setFractalPixelCallback = [fractal_ptr = this] (std::size_t spent_iterations, int px, int py)
+    runFrame(axis, true);
+}
+
+void MandelbrotFractal::calculate(const Axis& axis)
+{
+    runFrame(axis, false);
+}
+
+void MandelbrotFractal::runFrame(Axis const& axis, bool is_uploading)
+{
+    auto frame_begin = std::chrono::steady_clock::now();
+    last_frame_timing = { };
+
+    if (is_auto_iterations)
+    {
+        IterationsEstimate estimate = iterations_estimator.estimate(*calc_method, axis, limit_iterations.max);
+        current_iterations_count = estimate.iterations_count;
+
+        // Only a changed estimate, the views of a zoom mostly keep it
+        if (estimate.iterations_count != last_estimated_iterations_count)
+        {
+            last_estimated_iterations_count = estimate.iterations_count;
+            std::clog << std::format("Auto iterations: {} (sampling {:.2f} ms, saved ~{:.1f} ms against {})\n",
+                                     estimate.iterations_count, estimate.sampling_time.count(),
+                                     estimate.saved_time.count(), limit_iterations.max);
+        }
+    }
+
+    finished_rows.reset(height);
+    for (unsigned py = 0; py != height; ++py)
     {
+        rows_progress[py].pixels_count.store(0, std::memory_order_relaxed);
+    }
+    is_row_staged.assign(height, false);
+
+    std::atomic_flag is_first_result_set;
+    auto setFractalPixelCallback = [fractal_ptr = this, &is_first_result_set, frame_begin]
+        (std::size_t spent_iterations, int px, int py)
+    {
+        if (!is_first_result_set.test(std::memory_order_relaxed) && !is_first_result_set.test_and_set())
+        {
+            fractal_ptr->last_frame_timing.first_result = std::chrono::steady_clock::now() - frame_begin;
+        }
         fractal_ptr->setFractalPixel(spent_iterations, px, py);
     };
-    calc_method->calcFractal(static_cast<std::size_t>(current_iterations_count), axis, setFractalPixelCallback);
-    fractal_image.updateSprite();
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    thread_pool.setMainThreadIdleWork([this, is_uploading]
+    {
+        stageFinishedRows(is_uploading);
+    });
+    {
+        PerfPhase phase(calc_method->name());
+        calc_method->calcFractal(static_cast<std::size_t>(current_iterations_count), axis, setFractalPixelCallback);
+    }
+    thread_pool.setMainThreadIdleWork({ });
+
+    // The rows finished while the main thread was busy and the rows a calc method left untouched
+    stageFinishedRows(is_uploading);
+    staged_rows.clear();
+    for (unsigned py = 0; py != height; ++py)
+    {
+        if (!is_row_staged[py])
+        {
+            staged_rows.push_back(int(py));
+        }
+    }
+    stageRows(staged_rows, is_uploading);
+    last_frame_timing.final_image = std::chrono::steady_clock::now() - frame_begin;
+}
+
+MandelbrotFractal::FrameTiming MandelbrotFractal::lastFrameTiming() const
+{
+    return last_frame_timing;
+}
+
+int MandelbrotFractal::iterationsCount() const
+{
+    return current_iterations_count;
+}
+
+void MandelbrotFractal::setIterationsCount(int iterations_count)
+{
+    current_iterations_count = limit_iterations.clamp(iterations_count);
 }
 
 void MandelbrotFractal::shiftIterationsCount(int offset)
@@ -36,6 +122,11 @@ void MandelbrotFractal::shiftIterationsCount(int offset)
     current_iterations_count = limit_iterations.clamp(updated_iterations_count);
 }
 
+void MandelbrotFractal::toggleAutoIterations()
+{
+    is_auto_iterations = !is_auto_iterations;
+}
+
 void MandelbrotFractal::draw(sf::RenderTarget& target, sf::RenderStates states) const
 {
     target.draw(fractal_image, states);
@@ -43,11 +134,69 @@ void MandelbrotFractal::draw(sf::RenderTarget& target, sf::RenderStates states)
 
 void MandelbrotFractal::setFractalPixel(std::size_t iterations_spent, int px, int py)
 {
-    bool is_in_set = iterations_spent == std::numeric_limits<std::size_t>::max();
-    const sf::Color& pixel_color = is_in_set
-                                   ? sf::Color::Black
-                                   : color_table[iterations_spent % std::size(color_table)];
-    fractal_image.image.setPixel(unsigned(px), unsigned(py), pixel_color);
+    escape_times[std::size_t(py) * width + unsigned(px)] = iterations_spent;
+
+    // The last pixel of the row publishes the whole row: the counter orders the writes of all its threads
+    if (rows_progress[py].pixels_count.fetch_add(1, std::memory_order_acq_rel) + 1 == width)
+    {
+        finished_rows.push(py);
+        ThreadPoolSimpleInstance::get().notifyMainThread();
+    }
+}
+
+void MandelbrotFractal::stageFinishedRows(bool is_uploading)
+{
+    staged_rows.clear();
+    while (std::optional<int> row = finished_rows.tryPop())
+    {
+        staged_rows.push_back(*row);
+    }
+    stageRows(staged_rows, is_uploading);
+}
+
+void MandelbrotFractal::stageRows(std::vector<int>& rows, bool is_uploading)
+{
+    std::sort(rows.begin(), rows.end());
+    for (int py: rows)
+    {
+        std::size_t const* row_escape_times = &escape_times[std::size_t(py) * width];
+        for (unsigned px = 0; px != width; ++px)
+        {
+            fractal_image.setPixel(px, unsigned(py), color_table.colorOf(row_escape_times[px]));
+        }
+        is_row_staged[std::size_t(py)] = true;
+    }
+
+    if (!is_uploading)
+    {
+        return;
+    }
+    std::size_t run_begin = 0;
+    while (run_begin != rows.size())
+    {
+        std::size_t run_end = run_begin + 1;
+        while (run_end != rows.size() && rows[run_end] == rows[run_end - 1] + 1)
+        {
+            ++run_end;
+        }
+        fractal_image.updateRows(unsigned(rows[run_begin]), unsigned(run_end - run_begin));
+        run_begin = run_end;
+    }
+}
+
+void FractalImage::create(unsigned width, unsigned height)
+{
+    size = { width, height };
+    pixels = std::make_unique<sf::Uint8[]>(std::size_t(width) * height * 4);
+}
+
+void FractalImage::setPixel(unsigned px, unsigned py, sf::Color color)
+{
+    sf::Uint8* pixel = &pixels[(std::size_t(py) * size.x + px) * 4];
+    pixel[0] = color.r;
+    pixel[1] = color.g;
+    pixel[2] = color.b;
+    pixel[3] = color.a;
 }
 
 void FractalImage::draw(sf::RenderTarget& target, sf::RenderStates states) const
@@ -55,8 +204,12 @@ void FractalImage::draw(sf::RenderTarget& target, sf::RenderStates states) const
     target.draw(sprite, states);
 }
 
-void FractalImage::updateSprite()
+void FractalImage::updateRows(unsigned first_row, unsigned rows_count)
 {
-    texture.loadFromImage(image);
+    if (texture.getSize() != size)
+    {
+        texture.create(size.x, size.y);
+    }
+    texture.update(&pixels[std::size_t(first_row) * size.x * 4], size.x, rows_count, 0, first_row);
     sprite.setTexture(texture);
 }
@@ -4,44 +4,100 @@
 #include <SFML/Graphics.hpp>
 #include "../Utility/Functions.h"
 #include "../Multithreading/ThreadPool.h"
+#include "../Multithreading/BoundedMpscQueue.h"
 #include "Config.h"
+#include "ColorTable.h"
+#include "IterationsEstimator.h"
 
 class FractalImage : public sf::Drawable
 {
 public:
-    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    void create(unsigned width, unsigned height);
+
+    void setPixel(unsigned px, unsigned py, sf::Color color);
 
-    void updateSprite();
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
 
-    sf::Image image;
+    // Uploads only the given rows into the texture
+    void updateRows(unsigned first_row, unsigned rows_count);
 
 private:
+    sf::Vector2u size;
+    std::unique_ptr<sf::Uint8[]> pixels;
     sf::Texture texture;
     sf::Sprite sprite;
 };
 
 class FractalCalcMethod;
 
+// Frame pipeline: the workers store escape times and push every finished row into a lock-free queue,
+// the main thread colors the queued rows and uploads them between its own tasks, so only the last rows
+// are colored and uploaded after the computation
 class MandelbrotFractal : public sf::Drawable
 {
+public:
+    // Both measured from the start of the frame, the view change is already known
+    struct FrameTiming
+    {
+        std::chrono::duration<double, std::milli> first_result { };
+        std::chrono::duration<double, std::milli> final_image { };
+    };
+
 public:
     explicit MandelbrotFractal(const ProgramConfig& program_config);
 
     void update(Axis const& axis);
 
+    // Fills the image buffer only, the texture is not touched (works without a window)
+    void calculate(Axis const& axis);
+
+    [[nodiscard]] FrameTiming lastFrameTiming() const;
+
+    [[nodiscard]] int iterationsCount() const;
+
+    void setIterationsCount(int iterations_count);
+
     void shiftIterationsCount(int offset);
 
+    // The iterations count of every new view is estimated from a sparse sampling
+    void toggleAutoIterations();
+
     void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
 
 private:
+    // alignas: the rows counted by different threads don't share cache lines
+    struct alignas(64) RowProgress
+    {
+        std::atomic<unsigned> pixels_count = 0;
+    };
+
+    void runFrame(Axis const& axis, bool is_uploading);
+
     void setFractalPixel(std::size_t iterations_spent, int px, int py);
 
+    void stageFinishedRows(bool is_uploading);
+
+    // Colors the rows and uploads the runs of adjacent ones
+    void stageRows(std::vector<int>& rows, bool is_uploading);
+
 private:
+    unsigned width;
+    unsigned height;
     int current_iterations_count;
     MinMax<int> limit_iterations;
-    std::vector<sf::Color> color_table;
+    bool is_auto_iterations;
+    IterationsEstimator iterations_estimator;
+    int last_estimated_iterations_count = 0;
+    ColorTable color_table;
     FractalImage fractal_image;
     std::shared_ptr<FractalCalcMethod> calc_method;
+    FrameTiming last_frame_timing;
+
+    std::unique_ptr<std::size_t[]> escape_times;
+    std::unique_ptr<RowProgress[]> rows_progress;
+    BoundedMpscQueue<int> finished_rows;
+    std::vector<bool> is_row_staged;
+    std::vector<int> staged_rows;
 };
 
 #endif //MANDELBROT_CPP_MANDELBROTFRACTAL_H
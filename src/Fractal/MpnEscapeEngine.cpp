@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cmath>
+#include "MpnEscapeEngine.h"
+
+namespace
+{
+    constexpr int shift_bits = GMP_NUMB_BITS - MpnFixed::integer_bits;
+
+    mp_bitcnt_t fractionBits(std::size_t limbs_count)
+    {
+        return mp_bitcnt_t(GMP_NUMB_BITS) * limbs_count - MpnFixed::integer_bits;
+    }
+
+    long double limbsToReal(mp_limb_t const* limbs, std::size_t limbs_count, bool is_negative)
+    {
+        long double result = 0;
+        for (std::size_t i = 0; i != limbs_count; ++i)
+        {
+            result += std::ldexp(static_cast<long double>(limbs[i]),
+                                 int(GMP_NUMB_BITS * i) - int(fractionBits(limbs_count)));
+        }
+        return is_negative ? -result : result;
+    }
+}
+
+MpnFixed MpnFixed::fromMpf(mpf_class const& value, std::size_t limbs_count)
+{
+    mpf_class scaled(0, value.get_prec() + fractionBits(limbs_count));
+    mpf_mul_2exp(scaled.get_mpf_t(), mpf_class(abs(value)).get_mpf_t(), fractionBits(limbs_count));
+    mpz_class magnitude(scaled);
+
+    MpnFixed result;
+    result.limbs.assign(limbs_count + 1, 0);
+    std::size_t written_limbs = 0;
+    mpz_export(result.limbs.data(), &written_limbs, -1, sizeof(mp_limb_t), 0, GMP_NAIL_BITS, magnitude.get_mpz_t());
+    result.is_negative = value < 0;
+    return result;
+}
+
+MpnFixed MpnFixed::fromReal(long double value, std::size_t limbs_count)
+{
+    // long double is exactly the sum of two doubles
+    auto high = static_cast<double>(value);
+    auto low = static_cast<double>(value - high);
+    mpf_class exact(high, 2 * 64);
+    exact += low;
+    return fromMpf(exact, limbs_count);
+}
+
+std::size_t MpnFixed::limbsCount() const
+{
+    return limbs.size() - 1;
+}
+
+std::size_t MpnEscapeEngine::limbsForPixelSize(mpf_class const& pixel_size)
+{
+    long pixel_exponent = 0;
+    mpf_get_d_2exp(&pixel_exponent, pixel_size.get_mpf_t());
+    auto pixel_bits = std::size_t(std::max(1 - pixel_exponent, 0l));
+    std::size_t bits = MpnFixed::integer_bits + pixel_bits + GMP_NUMB_BITS;
+    return std::max<std::size_t>(2, (bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+}
+
+void MpnEscapeEngine::setLimbsCount(std::size_t new_limbs_count)
+{
+    if (new_limbs_count == limbs_count)
+    {
+        return;
+    }
+    limbs_count = new_limbs_count;
+
+    // Six values of limbs_count + 1 limbs and the double-width product
+    std::size_t value_size = limbs_count + 1;
+    buffer.assign(6 * value_size + 2 * limbs_count, 0);
+    Value* values[] = { &z_re, &z_im, &z_re_square, &z_im_square, &temp, &four };
+    for (std::size_t i = 0; i != std::size(values); ++i)
+    {
+        *values[i] = Value { buffer.data() + i * value_size, false };
+    }
+    product = buffer.data() + std::size(values) * value_size;
+    four.limbs[limbs_count - 1] = mp_limb_t(4) << shift_bits;
+}
+
+std::size_t MpnEscapeEngine::escapeTime(std::size_t iterations_count, MpnFixed const& c_re, MpnFixed const& c_im)
+{
+    resetOrbit();
+    for (std::size_t i = 0; i != iterations_count; ++i)
+    {
+        step(c_re, c_im);
+        if (isEscaped())
+        {
+            return i;
+        }
+    }
+    return std::numeric_limits<std::size_t>::max();
+}
+
+std::vector<Complex> const& MpnEscapeEngine::referenceOrbit(MpnFixed const& c_re, MpnFixed const& c_im,
+                                                             std::size_t iterations_count)
+{
+    setLimbsCount(c_re.limbsCount());
+
+    // Grows only for a longer orbit than any before, so a zoom that recomputes its reference doesn't allocate
+    orbit.clear();
+    orbit.reserve(iterations_count);
+
+    resetOrbit();
+    for (std::size_t i = 0; i != iterations_count; ++i)
+    {
+        step(c_re, c_im);
+        orbit.push_back(Complex { limbsToReal(z_re.limbs, limbs_count, z_re.is_negative),
+                                  limbsToReal(z_im.limbs, limbs_count, z_im.is_negative) });
+        if (isEscaped())
+        {
+            break;
+        }
+    }
+    return orbit;
+}
+
+void MpnEscapeEngine::addInPlace(MpnFixed& target, MpnFixed const& value) const
+{
+    Value target_value { target.limbs.data(), target.is_negative };
+    add(target_value, target_value, Value { const_cast<mp_limb_t*>(value.limbs.data()), value.is_negative });
+    target.is_negative = target_value.is_negative;
+}
+
+void MpnEscapeEngine::addScaledInPlace(MpnFixed& target, MpnFixed const& value, unsigned factor)
+{
+    mpn_mul_1(temp.limbs, value.limbs.data(), mp_size_t(limbs_count), factor);
+    temp.is_negative = value.is_negative;
+    Value target_value { target.limbs.data(), target.is_negative };
+    add(target_value, target_value, temp);
+    target.is_negative = target_value.is_negative;
+}
+
+void MpnEscapeEngine::resetOrbit()
+{
+    for (Value* value: { &z_re, &z_im, &z_re_square, &z_im_square })
+    {
+        std::fill_n(value->limbs, limbs_count + 1, 0);
+        value->is_negative = false;
+    }
+}
+
+void MpnEscapeEngine::step(MpnFixed const& c_re, MpnFixed const& c_im)
+{
+    // Inputs are only read, the views drop the constness for the mpn signatures
+    Value c_re_value { const_cast<mp_limb_t*>(c_re.limbs.data()), c_re.is_negative };
+    Value c_im_value { const_cast<mp_limb_t*>(c_im.limbs.data()), c_im.is_negative };
+
+    // z_im = 2*z_re*z_im + c_im
+    multiply(temp, z_re, z_im);
+    mpn_lshift(temp.limbs, temp.limbs, mp_size_t(limbs_count), 1);
+    add(z_im, temp, c_im_value);
+
+    // z_re = z_re^2 - z_im^2 + c_re, the squares are from the previous step
+    add(z_re, z_re_square, Value { z_im_square.limbs, true });
+    add(z_re, z_re, c_re_value);
+
+    square(z_re_square, z_re);
+    square(z_im_square, z_im);
+}
+
+bool MpnEscapeEngine::isEscaped()
+{
+    mpn_add_n(temp.limbs, z_re_square.limbs, z_im_square.limbs, mp_size_t(limbs_count));
+    return mpn_cmp(temp.limbs, four.limbs, mp_size_t(limbs_count)) > 0;
+}
+
+void MpnEscapeEngine::add(Value& out, Value const& a, Value const& b) const
+{
+    auto size = mp_size_t(limbs_count);
+    if (a.is_negative == b.is_negative)
+    {
+        mpn_add_n(out.limbs, a.limbs, b.limbs, size);
+        out.is_negative = a.is_negative;
+    }
+    else if (mpn_cmp(a.limbs, b.limbs, size) >= 0)
+    {
+        mpn_sub_n(out.limbs, a.limbs, b.limbs, size);
+        out.is_negative = a.is_negative;
+    }
+    else
+    {
+        mpn_sub_n(out.limbs, b.limbs, a.limbs, size);
+        out.is_negative = b.is_negative;
+    }
+}
+
+void MpnEscapeEngine::multiply(Value& out, Value const& a, Value const& b)
+{
+    mpn_mul_n(product, a.limbs, b.limbs, mp_size_t(limbs_count));
+    shiftProductInto(out);
+    out.is_negative = a.is_negative != b.is_negative;
+}
+
+void MpnEscapeEngine::square(Value& out, Value const& a)
+{
+    mpn_sqr(product, a.limbs, mp_size_t(limbs_count));
+    shiftProductInto(out);
+    out.is_negative = false;
+}
+
+void MpnEscapeEngine::shiftProductInto(Value& out)
+{
+    // The product has 2*fraction_bits: drop the lowest fraction_bits
+    mpn_rshift(out.limbs, product + (limbs_count - 1), mp_size_t(limbs_count + 1), shift_bits);
+}
@@ -0,0 +1,73 @@
+#ifndef MANDELBROT_CPP_MPNESCAPEENGINE_H
+#define MANDELBROT_CPP_MPNESCAPEENGINE_H
+
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+#include "../Utility/Types.h"
+
+// Sign and magnitude fixed-point value of limbs_count GMP limbs with 8 integer bits,
+// the layout MpnEscapeEngine iterates on. One spare limb receives the shifted products
+struct MpnFixed
+{
+    static constexpr int integer_bits = 8;
+
+    static MpnFixed fromMpf(mpf_class const& value, std::size_t limbs_count);
+    static MpnFixed fromReal(long double value, std::size_t limbs_count);
+
+    [[nodiscard]] std::size_t limbsCount() const;
+
+    std::vector<mp_limb_t> limbs;
+    bool is_negative = false;
+};
+
+// Escape-time iteration on the low-level mpn_* functions.
+// All temporaries live in buffers allocated once per engine (one engine per thread),
+// so no iteration allocates, unlike mpf_class expressions
+class MpnEscapeEngine
+{
+public:
+    // Enough limbs to tell apart the neighbour pixels of the given size, plus a guard limb
+    [[nodiscard]] static std::size_t limbsForPixelSize(mpf_class const& pixel_size);
+
+    // Reallocates the buffers only when the precision changes
+    void setLimbsCount(std::size_t limbs_count);
+
+    [[nodiscard]] std::size_t escapeTime(std::size_t iterations_count, MpnFixed const& c_re, MpnFixed const& c_im);
+
+    // z_1 .. z_n of c rounded to long double, up to the escape: the reference orbit of a perturbation render.
+    // The precision is the limbs count of c. The orbit lives in a buffer of the engine, valid until the next call
+    [[nodiscard]] std::vector<Complex> const& referenceOrbit(MpnFixed const& c_re, MpnFixed const& c_im,
+                                                             std::size_t iterations_count);
+
+    // target += value
+    void addInPlace(MpnFixed& target, MpnFixed const& value) const;
+
+    // target += value * factor
+    void addScaledInPlace(MpnFixed& target, MpnFixed const& value, unsigned factor);
+
+private:
+    struct Value
+    {
+        mp_limb_t* limbs;
+        bool is_negative;
+    };
+
+    void resetOrbit();
+    void step(MpnFixed const& c_re, MpnFixed const& c_im);
+    [[nodiscard]] bool isEscaped();
+
+    void add(Value& out, Value const& a, Value const& b) const;
+    void multiply(Value& out, Value const& a, Value const& b);
+    void square(Value& out, Value const& a);
+    void shiftProductInto(Value& out);
+
+private:
+    std::size_t limbs_count = 0;
+    std::vector<mp_limb_t> buffer;
+    Value z_re { }, z_im { }, z_re_square { }, z_im_square { }, temp { }, four { };
+    mp_limb_t* product = nullptr;
+    std::vector<Complex> orbit;
+};
+
+#endif //MANDELBROT_CPP_MPNESCAPEENGINE_H
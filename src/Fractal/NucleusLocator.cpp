@@ -0,0 +1,193 @@
+#include <limits>
+#include "NucleusLocator.h"
+
+namespace
+{
+    template<class T>
+    struct ComplexOf
+    {
+        T re;
+        T im;
+    };
+
+    // long double, or a GMP float of the given bits
+    template<class T>
+    T makeNumber(Real value, mp_bitcnt_t bits)
+    {
+        if constexpr (std::is_same_v<T, mpf_class>)
+        {
+            // mpf takes doubles only: the 64-bit mantissa goes in two parts
+            auto high = double(value);
+            mpf_class number(high, bits);
+            number += double(value - high);
+            return number;
+        }
+        else
+        {
+            return value;
+        }
+    }
+
+    Real toReal(mpf_class const& value)
+    {
+        double high = value.get_d();
+        mpf_class low(value - high, value.get_prec());
+        return Real(high) + low.get_d();
+    }
+
+    Real toReal(Real value)
+    {
+        return value;
+    }
+
+    bool isFinite(mpf_class const&)
+    {
+        return true;
+    }
+
+    bool isFinite(Real value)
+    {
+        return std::isfinite(value);
+    }
+
+    // Moves c to the root of z_period(c) = 0. True when the step fell under the precision of bits at c
+    template<class T>
+    bool runNewton(ComplexOf<T>& c, std::size_t period, int max_steps, mp_bitcnt_t bits)
+    {
+        ComplexOf<T> z { makeNumber<T>(0, bits), makeNumber<T>(0, bits) };
+        ComplexOf<T> dz = z;
+        ComplexOf<T> step = z;
+        T temp = makeNumber<T>(0, bits);
+        T dz_norm = temp;
+        T c_norm = temp;
+        T tolerance = makeNumber<T>(std::ldexp(Real(1), -2 * (int(bits) - 8)), bits);
+
+        for (int i = 0; i != max_steps; ++i)
+        {
+            z.re = 0;
+            z.im = 0;
+            dz.re = 0;
+            dz.im = 0;
+            for (std::size_t n = 0; n != period; ++n)
+            {
+                // dz = 2 z dz + 1, z = z^2 + c
+                temp = 2 * (z.re * dz.re - z.im * dz.im) + 1;
+                dz.im = 2 * (z.re * dz.im + z.im * dz.re);
+                dz.re = temp;
+                temp = z.re * z.re - z.im * z.im + c.re;
+                z.im = 2 * z.re * z.im + c.im;
+                z.re = temp;
+            }
+
+            dz_norm = dz.re * dz.re + dz.im * dz.im;
+            if (!(dz_norm > 0))
+            {
+                return false;
+            }
+            step.re = (z.re * dz.re + z.im * dz.im) / dz_norm;
+            step.im = (z.im * dz.re - z.re * dz.im) / dz_norm;
+            if (!isFinite(step.re) || !isFinite(step.im))
+            {
+                return false;
+            }
+            c.re -= step.re;
+            c.im -= step.im;
+
+            c_norm = c.re * c.re + c.im * c.im + 1;
+            if (step.re * step.re + step.im * step.im <= c_norm * tolerance)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // |1 / (beta lambda^2)|, where lambda is the product of 2 z_n over the cycle without its last step
+    // and beta is the sum of the reciprocals of its partial products
+    template<class T>
+    Real estimateSize(ComplexOf<T> const& c, std::size_t period, mp_bitcnt_t bits)
+    {
+        ComplexOf<T> z { makeNumber<T>(0, bits), makeNumber<T>(0, bits) };
+        ComplexOf<T> lambda { makeNumber<T>(1, bits), makeNumber<T>(0, bits) };
+        ComplexOf<T> beta = lambda;
+        T temp = makeNumber<T>(0, bits);
+        T lambda_norm = temp;
+
+        for (std::size_t n = 1; n < period; ++n)
+        {
+            temp = z.re * z.re - z.im * z.im + c.re;
+            z.im = 2 * z.re * z.im + c.im;
+            z.re = temp;
+
+            temp = 2 * (z.re * lambda.re - z.im * lambda.im);
+            lambda.im = 2 * (z.re * lambda.im + z.im * lambda.re);
+            lambda.re = temp;
+
+            lambda_norm = lambda.re * lambda.re + lambda.im * lambda.im;
+            if (!(lambda_norm > 0))
+            {
+                return 0;
+            }
+            beta.re += lambda.re / lambda_norm;
+            beta.im -= lambda.im / lambda_norm;
+        }
+
+        if (period == 1)
+        {
+            return 1;
+        }
+        using std::sqrt;
+        temp = sqrt(beta.re * beta.re + beta.im * beta.im) * lambda_norm;
+        return 1 / toReal(temp);
+    }
+}
+
+std::optional<std::size_t> NucleusLocator::findPeriod(Complex point, Real radius, std::size_t max_period)
+{
+    Complex z { 0, 0 };
+    Complex dz { 0, 0 };
+    for (std::size_t n = 1; n <= max_period; ++n)
+    {
+        dz = { 2 * (z.re * dz.re - z.im * dz.im) + 1, 2 * (z.re * dz.im + z.im * dz.re) };
+        z = { z.re * z.re - z.im * z.im + point.re, 2 * z.re * z.im + point.im };
+
+        Real z_norm = z.re * z.re + z.im * z.im;
+        if (z_norm > 4)
+        {
+            return std::nullopt;
+        }
+        if (z_norm < radius * radius * (dz.re * dz.re + dz.im * dz.im))
+        {
+            return n;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Nucleus> NucleusLocator::locate(Complex start, std::size_t period)
+{
+    constexpr mp_bitcnt_t real_bits = std::numeric_limits<Real>::digits;
+
+    ComplexOf<Real> c { start.re, start.im };
+    bool is_converged = runNewton(c, period, max_newton_steps, real_bits);
+    Real size = estimateSize(c, period, real_bits);
+    if (!isFinite(c.re) || !isFinite(c.im) || !isFinite(size) || !(size > 0))
+    {
+        return std::nullopt;
+    }
+
+    if (!is_converged || size < refine_size)
+    {
+        // The orbit of c amplifies its rounding about as 1 / size does
+        auto bits = mp_bitcnt_t(real_bits + 2 * std::max(0, int(std::ceil(-std::log2(size)))));
+        ComplexOf<mpf_class> precise_c { makeNumber<mpf_class>(c.re, bits), makeNumber<mpf_class>(c.im, bits) };
+        if (!runNewton(precise_c, period, max_newton_steps, bits))
+        {
+            return std::nullopt;
+        }
+        c = { toReal(precise_c.re), toReal(precise_c.im) };
+        size = estimateSize(precise_c, period, bits);
+    }
+
+    return Nucleus { Complex { c.re, c.im }, period, size };
+}
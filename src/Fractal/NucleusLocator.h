@@ -0,0 +1,34 @@
+#ifndef MANDELBROT_CPP_NUCLEUSLOCATOR_H
+#define MANDELBROT_CPP_NUCLEUSLOCATOR_H
+
+#include <optional>
+#include "../Utility/Types.h"
+
+// Center of a hyperbolic component of the Mandelbrot set: z_period(center) = 0
+struct Nucleus
+{
+    Complex center;
+    std::size_t period;
+
+    // Radius of the mini-brot around the component, 1 for the whole set
+    Real size;
+};
+
+// Finds the nucleus of a mini-brot near a point, so the view jumps there without rendering the zooms in between
+class NucleusLocator
+{
+public:
+    // Lowest period of the nuclei within radius of the point: the first iteration whose image of the disk,
+    // linearized by dz/dc, contains the origin. Empty when the orbit escapes first or max_period is reached
+    [[nodiscard]] static std::optional<std::size_t> findPeriod(Complex point, Real radius, std::size_t max_period);
+
+    // Newton's method on z_period(c) = 0 from the start point in long double. A nucleus smaller than refine_size,
+    // or one long double does not converge to, is refined on GMP floats with the bits its size needs
+    [[nodiscard]] static std::optional<Nucleus> locate(Complex start, std::size_t period);
+
+private:
+    static constexpr int max_newton_steps = 64;
+    static constexpr Real refine_size = 1e-10L;
+};
+
+#endif //MANDELBROT_CPP_NUCLEUSLOCATOR_H
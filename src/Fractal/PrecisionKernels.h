@@ -0,0 +1,32 @@
+#ifndef MANDELBROT_CPP_PRECISIONKERNELS_H
+#define MANDELBROT_CPP_PRECISIONKERNELS_H
+
+#include <cstddef>
+#include <limits>
+
+// Mandelbrot escape time for any real type with +, -, * and >: long double, FixedPoint, mpf_class.
+// Same result convention as FractalCalcMethod::isInFractalBody
+template<class Number>
+std::size_t escapeTime(std::size_t iterations_count, Number const& c_re, Number const& c_im)
+{
+    Number four(4);
+    Number z_re(0), z_im(0), z_re_square(0), z_im_square(0);
+
+    for (std::size_t i = 0; i != iterations_count; ++i)
+    {
+        z_im = z_re * z_im;
+        z_im = z_im + z_im + c_im;
+        z_re = z_re_square - z_im_square + c_re;
+
+        z_re_square = z_re * z_re;
+        z_im_square = z_im * z_im;
+        if (z_re_square + z_im_square > four)
+        {
+            return i;
+        }
+    }
+
+    return std::numeric_limits<std::size_t>::max();
+}
+
+#endif //MANDELBROT_CPP_PRECISIONKERNELS_H
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <limits>
 #include "Zoomer.h"
 
 Zoomer::Zoomer(Axis& axis, Real scale_factor)
@@ -45,14 +47,27 @@ void Zoomer::drawZoomCorners(sf::RenderTarget& target, sf::RenderStates states)
     Complex zoomerCornerMax = { axis.screenToCartesianX(screenCorners.x.max),
                                 axis.screenToCartesianY(screenCorners.y.max) };
 
-    ComplexNumberAtScreenPos numbers_at_pos[] = {
-        { zoomerCornerMin, MinMax<int> { screenCorners.x.min, screenCorners.y.min } },
-        { zoomerCornerMax, MinMax<int> { screenCorners.x.max, screenCorners.y.max } }
-    };
+    if (corner_numbers.empty() || shown_corners != screenCorners ||
+        shown_numbers[0] != zoomerCornerMin || shown_numbers[1] != zoomerCornerMax)
+    {
+        ComplexNumberAtScreenPos numbers_at_pos[] = {
+            { zoomerCornerMin, MinMax<int> { screenCorners.x.min, screenCorners.y.min } },
+            { zoomerCornerMax, MinMax<int> { screenCorners.x.max, screenCorners.y.max } }
+        };
+
+        corner_numbers.clear();
+        for (auto const& number_at_pos: numbers_at_pos)
+        {
+            corner_numbers.emplace_back(number_at_pos, screenCorners);
+        }
+        shown_corners = screenCorners;
+        shown_numbers[0] = zoomerCornerMin;
+        shown_numbers[1] = zoomerCornerMax;
+    }
 
-    for (auto const& number_at_pos: numbers_at_pos)
+    for (DrawableNumber const& number: corner_numbers)
     {
-        target.draw(DrawableNumber(number_at_pos, screenCorners), states);
+        target.draw(number, states);
     }
 }
 
@@ -94,3 +109,18 @@ void Zoomer::zoomOut(sf::Vector2i mouse_pos)
     scale_factor = prev;
     updateRectSizesByScaleFactor();
 }
+
+void Zoomer::jumpTo(Complex center, Real half_height)
+{
+    int height = std::max(axis.screen_borders.y.max - axis.screen_borders.y.min, 1);
+    Real min_half_height = std::max({ std::abs(center.re), std::abs(center.im), Real(1) }) * height *
+                           std::numeric_limits<Real>::epsilon() * min_pixel_ulps / 2;
+    half_height = std::max(half_height, min_half_height);
+
+    Real aspect_ratio = (axis.cartesian_borders.x.max - axis.cartesian_borders.x.min) /
+                        (axis.cartesian_borders.y.max - axis.cartesian_borders.y.min);
+    Real half_width = half_height * aspect_ratio;
+
+    axis.cartesian_borders.x = { center.re - half_width, center.re + half_width };
+    axis.cartesian_borders.y = { center.im - half_height, center.im + half_height };
+}
@@ -2,6 +2,7 @@
 #define MANDELBROT_CPP_ZOOMER_H
 
 #include <SFML/Graphics.hpp>
+#include <vector>
 #include "../Utility/Types.h"
 
 class Zoomer : public sf::Drawable
@@ -22,6 +23,9 @@ public:
     void zoomIn();
     void zoomOut(sf::Vector2i mouse_pos);
 
+    // Centers the view on the point with the aspect ratio kept. Not deeper than long double resolves pixels at it
+    void jumpTo(Complex center, Real half_height);
+
     Axis& axis;
     Real scale_factor;
     sf::RectangleShape zoom_rect;
@@ -29,6 +33,14 @@ public:
 private:
     void drawZoomCorners(sf::RenderTarget& target, sf::RenderStates states) const;
     PlaneBorders<int> calcZoomRectCorners() const;
+
+private:
+    static constexpr Real min_pixel_ulps = 16;
+
+    // Text layout of the corner numbers is rebuilt only when the corners or the numbers change
+    mutable std::vector<DrawableNumber> corner_numbers;
+    mutable PlaneBorders<int> shown_corners = { MinMax<int> { 0, 0 }, MinMax<int> { 0, 0 }};
+    mutable Complex shown_numbers[2] = { };
 };
 
 
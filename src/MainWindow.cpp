@@ -1,3 +1,4 @@
+#include <format>
 #include "MainWindow.h"
 #include "Utility/Functions.h"
 
@@ -5,11 +6,16 @@ using namespace std::chrono_literals;
 
 
 MainWindow::MainWindow(const ProgramConfig& program_config)
-    : window { program_config.window_mode, "MandelbrotFractal" }
+    : window { program_config.window_mode, window_title }
     , axis { program_config.axis }
     , zoomer { axis, program_config.initial_zoom_rect_ratio }
     , mandelbrot_fractal { program_config }
+    , julia_preview { program_config }
 {
+    if (!program_config.interaction_log_path.empty())
+    {
+        interaction_recorder = std::make_unique<InteractionRecorder>(program_config.interaction_log_path);
+    }
     initSfmlEventHandler();
 }
 
@@ -17,7 +23,11 @@ void MainWindow::startLoop()
 {
     while (is_program_work)
     {
-        draw();
+        if (is_redraw_needed)
+        {
+            draw();
+            is_redraw_needed = false;
+        }
         handleInput();
         update();
     }
@@ -25,9 +35,18 @@ void MainWindow::startLoop()
 
 void MainWindow::handleInput()
 {
+    // Nothing to compute: sleep in the event queue instead of spinning
+    bool is_idle = isIdle();
     sf::Event e { };
-    while (window.pollEvent(e))
+    bool is_event_got = is_idle ? window.waitEvent(e) : window.pollEvent(e);
+    if (!is_event_got && !is_idle)
     {
+        sf::sleep(sf::milliseconds(1));
+    }
+
+    for (; is_event_got; is_event_got = window.pollEvent(e))
+    {
+        is_redraw_needed = true;
         if (!sfml_event_handler.contains(e.type))
         {
             continue;
@@ -36,16 +55,23 @@ void MainWindow::handleInput()
         (this->*sfml_event_handler[e.type])(e);
     }
 
-    handleMouseButtonMoving();
     handleMouseButtonIsPressing();
 }
 
+bool MainWindow::isIdle() const
+{
+    return !is_fractal_recalc_needed && !julia_preview.isBusy() &&
+           !sf::Mouse::isButtonPressed(sf::Mouse::Button::XButton1) &&
+           !sf::Mouse::isButtonPressed(sf::Mouse::Button::XButton2);
+}
+
 void MainWindow::initSfmlEventHandler()
 {
     sfml_event_handler[sf::Event::EventType::Closed] = &MainWindow::handleProgramClose;
     sfml_event_handler[sf::Event::EventType::KeyPressed] = &MainWindow::handlePressedKeyKeyboard;
     sfml_event_handler[sf::Event::EventType::MouseButtonPressed] = &MainWindow::handlePressedKeyMouse;
     sfml_event_handler[sf::Event::EventType::MouseWheelScrolled] = &MainWindow::handleMouseWheelScroller;
+    sfml_event_handler[sf::Event::EventType::MouseMoved] = &MainWindow::handleMouseMoved;
 }
 
 void MainWindow::handleProgramClose(const sf::Event&)
@@ -58,12 +84,25 @@ void MainWindow::handlePressedKeyKeyboard(const sf::Event& e)
     if (e.key.code == sf::Keyboard::Space || e.key.code == sf::Keyboard::Add)
     {
         mandelbrot_fractal.shiftIterationsCount(+60);
-        is_fractal_recalc_needed = true;
+        noteInteraction("iterations-up");
     }
     else if (e.key.code == sf::Keyboard::N || e.key.code == sf::Keyboard::Subtract)
     {
         mandelbrot_fractal.shiftIterationsCount(-20);
-        is_fractal_recalc_needed = true;
+        noteInteraction("iterations-down");
+    }
+    else if (e.key.code == sf::Keyboard::A)
+    {
+        mandelbrot_fractal.toggleAutoIterations();
+        noteInteraction("auto-iterations");
+    }
+    else if (e.key.code == sf::Keyboard::J)
+    {
+        julia_preview.toggle();
+    }
+    else if (e.key.code == sf::Keyboard::M)
+    {
+        jumpToNucleus();
     }
 }
 
@@ -73,13 +112,13 @@ void MainWindow::handlePressedKeyMouse(const sf::Event& e)
     {
         mandelbrot_fractal.shiftIterationsCount(+5);
         zoomer.zoomIn();
-        is_fractal_recalc_needed = true;
+        noteInteraction("click-zoom-in");
     }
     else if (e.mouseButton.button == sf::Mouse::Button::Right)
     {
         mandelbrot_fractal.shiftIterationsCount(-5);
         zoomer.zoomOut(sf::Mouse::getPosition(window));
-        is_fractal_recalc_needed = true;
+        noteInteraction("click-zoom-out");
     }
 }
 
@@ -89,18 +128,19 @@ void MainWindow::handleMouseWheelScroller(const sf::Event& e)
     {
         mandelbrot_fractal.shiftIterationsCount(+3);
         zoomer.zoomIn();
+        noteInteraction("wheel-zoom-in");
     }
     else
     {
         mandelbrot_fractal.shiftIterationsCount(-2);
         zoomer.zoomOut(sf::Mouse::getPosition(window));
+        noteInteraction("wheel-zoom-out");
     }
-    is_fractal_recalc_needed = true;
 }
 
-void MainWindow::handleMouseButtonMoving()
+void MainWindow::handleMouseMoved(const sf::Event& e)
 {
-    zoomer.setZoomRectanglePosition(sf::Mouse::getPosition(window));
+    zoomer.setZoomRectanglePosition(sf::Vector2i(e.mouseMove.x, e.mouseMove.y));
 }
 
 void MainWindow::handleMouseButtonIsPressing()
@@ -113,19 +153,65 @@ void MainWindow::handleMouseButtonIsPressing()
     if (sf::Mouse::isButtonPressed(sf::Mouse::Button::XButton1))
     {
         zoomer.shiftScaleFactor(0.005);
+        is_redraw_needed = true;
     }
     else if (sf::Mouse::isButtonPressed(sf::Mouse::Button::XButton2))
     {
         zoomer.shiftScaleFactor(-0.005);
+        is_redraw_needed = true;
     }
 }
 
+void MainWindow::jumpToNucleus()
+{
+    sf::Vector2i mouse_pos = sf::Mouse::getPosition(window);
+    Complex point { axis.screenToCartesianX(mouse_pos.x), axis.screenToCartesianY(mouse_pos.y) };
+    auto rect_height = int(zoomer.zoom_rect.getSize().y);
+    Real radius = std::abs(axis.screenToCartesianY(rect_height) - axis.screenToCartesianY(0)) / 2;
+
+    auto max_period = std::size_t(mandelbrot_fractal.iterationsCount());
+    std::optional<std::size_t> period = NucleusLocator::findPeriod(point, radius, max_period);
+    std::optional<Nucleus> nucleus = period ? NucleusLocator::locate(point, *period) : std::nullopt;
+    if (!nucleus || std::hypot(nucleus->center.re - point.re, nucleus->center.im - point.im) > radius)
+    {
+        window.setTitle(std::format("{} - no nucleus inside the zoom rectangle", window_title));
+        return;
+    }
+    window.setTitle(std::format("{} - nucleus of period {} at {:.20g} {:+.20g}i, size {:.3g}", window_title,
+                                nucleus->period, nucleus->center.re, nucleus->center.im, nucleus->size));
+
+    zoomer.jumpTo(nucleus->center, nucleus->size * nucleus_view_to_size);
+    auto period_iterations = std::min<std::size_t>(nucleus->period * nucleus_iterations_per_period,
+                                                   std::numeric_limits<int>::max());
+    mandelbrot_fractal.setIterationsCount(std::max(mandelbrot_fractal.iterationsCount(), int(period_iterations)));
+    noteInteraction("nucleus-jump");
+}
+
+void MainWindow::noteInteraction(std::string const& action)
+{
+    frame_interactions.push_back(action);
+    is_fractal_recalc_needed = true;
+}
+
 void MainWindow::update()
 {
     if (is_fractal_recalc_needed)
     {
         mandelbrot_fractal.update(axis);
         is_fractal_recalc_needed = false;
+        is_redraw_needed = true;
+
+        if (interaction_recorder && !frame_interactions.empty())
+        {
+            interaction_recorder->record(frame_interactions, axis, mandelbrot_fractal.iterationsCount());
+        }
+        frame_interactions.clear();
+    }
+
+    sf::Vector2i mouse_pos = sf::Mouse::getPosition(window);
+    if (julia_preview.update(Complex { axis.screenToCartesianX(mouse_pos.x), axis.screenToCartesianY(mouse_pos.y) }))
+    {
+        is_redraw_needed = true;
     }
 }
 
@@ -134,5 +220,6 @@ void MainWindow::draw()
     window.clear(sf::Color::White);
     window.draw(mandelbrot_fractal);
     window.draw(zoomer);
+    window.draw(julia_preview);
     window.display();
 }
@@ -5,7 +5,10 @@
 #include <unordered_map>
 #include "Fractal/MandelbrotFractal.h"
 #include "Fractal/Zoomer.h"
+#include "Fractal/JuliaPreview.h"
+#include "Fractal/NucleusLocator.h"
 #include "Fractal/Config.h"
+#include "Utility/InteractionLog.h"
 
 class MainWindow
 {
@@ -16,31 +19,47 @@ public:
 
 private:
     void handleInput();
+    [[nodiscard]] bool isIdle() const;
     void initSfmlEventHandler();
     void handleProgramClose(const sf::Event&);
     void handlePressedKeyKeyboard(const sf::Event& e);
     void handlePressedKeyMouse(const sf::Event& e);
     void handleMouseWheelScroller(const sf::Event& e);
+    void handleMouseMoved(const sf::Event& e);
 
-    void handleMouseButtonMoving();
     void handleMouseButtonIsPressing();
 
+    // The nucleus of the lowest period inside the zoom rectangle, the view jumps to its mini-brot.
+    // The found nucleus is shown in the window title
+    void jumpToNucleus();
+
+    // Logged with the resulting view once the frame is done, with the other actions of the same frame
+    void noteInteraction(std::string const& action);
+
     void update();
 
     void draw();
 
 private:
+    static constexpr char const* window_title = "MandelbrotFractal";
+    static constexpr Real nucleus_view_to_size = 2.5;
+    static constexpr int nucleus_iterations_per_period = 64;
+
     bool is_program_work = true;
 
     using WindowEventHandlerFunc = decltype(&MainWindow::handleProgramClose);
     std::unordered_map<sf::Event::EventType, WindowEventHandlerFunc> sfml_event_handler;
 
     bool is_fractal_recalc_needed = true;
+    bool is_redraw_needed = true;
     sf::RenderWindow window;
     Axis axis;
     Zoomer zoomer;
     Timer zoom_rect_change_timeout;
     MandelbrotFractal mandelbrot_fractal;
+    JuliaPreview julia_preview;
+    std::unique_ptr<InteractionRecorder> interaction_recorder;
+    std::vector<std::string> frame_interactions;
 };
 
 
@@ -0,0 +1,67 @@
+#ifndef MANDELBROT_CPP_BOUNDEDMPSCQUEUE_H
+#define MANDELBROT_CPP_BOUNDEDMPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+// Lock-free queue for at most capacity pushes between resets. A producer claims a slot with one fetch_add
+// and publishes it, the single consumer takes the slots in the order they were claimed
+template<class T>
+class BoundedMpscQueue
+{
+public:
+    // No push or pop may run meanwhile
+    void reset(std::size_t new_capacity)
+    {
+        if (new_capacity != capacity)
+        {
+            slots = std::make_unique<Slot[]>(new_capacity);
+            capacity = new_capacity;
+        }
+        for (std::size_t i = 0; i != capacity; ++i)
+        {
+            slots[i].is_published.store(false, std::memory_order_relaxed);
+        }
+        tail.store(0, std::memory_order_relaxed);
+        head = 0;
+    }
+
+    // False when the queue is full
+    bool push(T value)
+    {
+        std::size_t index = tail.fetch_add(1, std::memory_order_relaxed);
+        if (index >= capacity)
+        {
+            return false;
+        }
+        slots[index].value = std::move(value);
+        slots[index].is_published.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Empty until the oldest claimed slot is published
+    std::optional<T> tryPop()
+    {
+        if (head == capacity || !slots[head].is_published.load(std::memory_order_acquire))
+        {
+            return std::nullopt;
+        }
+        return std::move(slots[head++].value);
+    }
+
+private:
+    struct Slot
+    {
+        T value { };
+        std::atomic<bool> is_published = false;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t capacity = 0;
+    std::atomic<std::size_t> tail = 0;
+    std::size_t head = 0;
+};
+
+#endif //MANDELBROT_CPP_BOUNDEDMPSCQUEUE_H
@@ -0,0 +1,72 @@
+#ifndef MANDELBROT_CPP_COMPLETIONLATCH_H
+#define MANDELBROT_CPP_COMPLETIONLATCH_H
+
+#include <atomic>
+#include <thread>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Counts the unfinished tasks of a batch.
+// The waiter spins for a short while (the end of a frame is usually near) and then parks on the
+// atomic itself (futex on Linux, WaitOnAddress on Windows) until the last task counts down.
+class CompletionLatch
+{
+public:
+    void countUp(std::size_t tasks_count)
+    {
+        pending_tasks.fetch_add(tasks_count, std::memory_order_relaxed);
+    }
+
+    // True when it was the last task
+    bool countDown()
+    {
+        if (pending_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            pending_tasks.notify_all();
+            return true;
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool isReleased() const
+    {
+        return pending_tasks.load(std::memory_order_acquire) == 0;
+    }
+
+    void wait() const
+    {
+        for (int i = 0; i != spins_before_park; ++i)
+        {
+            if (isReleased())
+            {
+                return;
+            }
+            pause();
+        }
+
+        std::size_t pending;
+        while ((pending = pending_tasks.load(std::memory_order_acquire)) != 0)
+        {
+            pending_tasks.wait(pending, std::memory_order_acquire);
+        }
+    }
+
+private:
+    static void pause()
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+private:
+    static constexpr int spins_before_park = 4'000;
+    std::atomic<std::size_t> pending_tasks = 0;
+};
+
+#endif //MANDELBROT_CPP_COMPLETIONLATCH_H
@@ -0,0 +1,186 @@
+#include <thread>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <charconv>
+#include <format>
+#include <stdexcept>
+#include "CpuTopology.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    int parseCpu(std::string const& cpu_list, std::string const& text)
+    {
+        int cpu = -1;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), cpu);
+        if (error != std::errc() || end != text.data() + text.size() || cpu < 0)
+        {
+            throw std::invalid_argument(std::format("Bad CPU list \"{}\": \"{}\" is not a CPU number", cpu_list, text));
+        }
+        return cpu;
+    }
+}
+
+CpuTopology CpuTopology::detect()
+{
+    CpuTopology topology;
+
+#if defined(_WIN32)
+    ULONG highest_node = 0;
+    if (GetNumaHighestNodeNumber(&highest_node))
+    {
+        for (ULONG node = 0; node <= highest_node; ++node)
+        {
+            ULONGLONG mask = 0;
+            if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask) || mask == 0)
+            {
+                continue;
+            }
+            std::vector<int>& cpus = topology.node_cpus.emplace_back();
+            for (int cpu = 0; cpu != 64; ++cpu)
+            {
+                if (mask & (1ull << cpu))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+    }
+#elif defined(__linux__)
+    namespace fs = std::filesystem;
+    std::error_code error;
+    for (int node = 0; fs::exists("/sys/devices/system/node/node" + std::to_string(node), error); ++node)
+    {
+        std::ifstream cpu_list_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string cpu_list;
+        std::getline(cpu_list_file, cpu_list);
+        if (std::vector<int> cpus = parseCpuList(cpu_list); !cpus.empty())
+        {
+            topology.node_cpus.push_back(std::move(cpus));
+        }
+    }
+#endif
+
+    if (topology.node_cpus.empty())
+    {
+        std::vector<int>& cpus = topology.node_cpus.emplace_back();
+        for (int cpu = 0; cpu < static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)); ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return topology;
+}
+
+std::vector<int> CpuTopology::allCpus() const
+{
+    std::vector<int> cpus;
+    for (std::vector<int> const& node: node_cpus)
+    {
+        cpus.insert(cpus.end(), node.begin(), node.end());
+    }
+    return cpus;
+}
+
+std::size_t CpuTopology::nodeOf(int cpu) const
+{
+    for (std::size_t node = 0; node != node_cpus.size(); ++node)
+    {
+        if (std::find(node_cpus[node].begin(), node_cpus[node].end(), cpu) != node_cpus[node].end())
+        {
+            return node;
+        }
+    }
+    throw std::invalid_argument(std::format("CPU {} is not among the CPUs of this host ({})", cpu,
+                                            formatCpuList(allCpus())));
+}
+
+void CpuTopology::checkCpus(std::vector<int> const& cpus) const
+{
+    for (int cpu: cpus)
+    {
+        static_cast<void>(nodeOf(cpu));
+    }
+}
+
+std::vector<int> parseCpuList(std::string const& cpu_list)
+{
+    std::vector<int> cpus;
+    std::stringstream list_stream(cpu_list);
+    std::string range;
+    while (std::getline(list_stream, range, ','))
+    {
+        if (range.empty())
+        {
+            continue;
+        }
+        std::size_t dash = range.find('-');
+        int first = parseCpu(cpu_list, range.substr(0, dash));
+        int last = dash == std::string::npos ? first : parseCpu(cpu_list, range.substr(dash + 1));
+        if (last < first)
+        {
+            throw std::invalid_argument(std::format("Bad CPU list \"{}\": the range {} is empty", cpu_list, range));
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::string formatCpuList(std::vector<int> const& cpus)
+{
+    std::string cpu_list;
+    for (std::size_t i = 0; i != cpus.size();)
+    {
+        std::size_t range_end = i + 1;
+        while (range_end != cpus.size() && cpus[range_end] == cpus[range_end - 1] + 1)
+        {
+            ++range_end;
+        }
+        cpu_list += (cpu_list.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (range_end - i > 1)
+        {
+            cpu_list += "-" + std::to_string(cpus[range_end - 1]);
+        }
+        i = range_end;
+    }
+    return cpu_list;
+}
+
+bool pinCurrentThreadToCpus(std::vector<int> const& cpus)
+{
+    if (cpus.empty())
+    {
+        return true;
+    }
+
+#if defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu: cpus)
+    {
+        mask |= DWORD_PTR(1) << cpu;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu: cpus)
+    {
+        CPU_SET(static_cast<std::size_t>(cpu), &cpu_set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,32 @@
+#ifndef MANDELBROT_CPP_CPUTOPOLOGY_H
+#define MANDELBROT_CPP_CPUTOPOLOGY_H
+
+#include <vector>
+#include <string>
+
+struct CpuTopology
+{
+    // Reads the NUMA nodes of the host. Without NUMA information all CPUs form a single node
+    static CpuTopology detect();
+
+    [[nodiscard]] std::vector<int> allCpus() const;
+
+    // Index of the node of the CPU. Throws std::invalid_argument for a CPU the host doesn't have
+    [[nodiscard]] std::size_t nodeOf(int cpu) const;
+
+    // Throws std::invalid_argument if the host doesn't have one of the CPUs
+    void checkCpus(std::vector<int> const& cpus) const;
+
+    std::vector<std::vector<int>> node_cpus;
+};
+
+// Parses lists like "0-3,8,10-11". Throws std::invalid_argument for a malformed list
+std::vector<int> parseCpuList(std::string const& cpu_list);
+
+// The inverse of parseCpuList, for messages
+std::string formatCpuList(std::vector<int> const& cpus);
+
+// Binds the calling thread to the given CPUs. Empty list leaves the affinity untouched
+bool pinCurrentThreadToCpus(std::vector<int> const& cpus);
+
+#endif //MANDELBROT_CPP_CPUTOPOLOGY_H
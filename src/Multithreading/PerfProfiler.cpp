@@ -0,0 +1,330 @@
+#include <format>
+#include "PerfProfiler.h"
+#include "ThreadPoolInstance.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    PerfCounters& threadCounters()
+    {
+        thread_local PerfCounters counters;
+        return counters;
+    }
+
+    double perKiloInstructions(std::uint64_t events, std::uint64_t instructions)
+    {
+        return instructions ? 1000.0 * double(events) / double(instructions) : 0.0;
+    }
+
+#if defined(__linux__)
+    int openCounter(std::uint64_t config, int group_fd)
+    {
+        perf_event_attr attributes { };
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = config;
+        attributes.disabled = group_fd == -1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return int(syscall(SYS_perf_event_open, &attributes, 0, -1, group_fd, 0));
+    }
+#endif
+}
+
+PerfSample& PerfSample::operator +=(PerfSample const& other)
+{
+    cycles += other.cycles;
+    instructions += other.instructions;
+    branch_misses += other.branch_misses;
+    cache_misses += other.cache_misses;
+    time_enabled += other.time_enabled;
+    time_running += other.time_running;
+    return *this;
+}
+
+PerfSample PerfSample::operator -(PerfSample const& other) const
+{
+    return {
+        cycles - other.cycles, instructions - other.instructions,
+        branch_misses - other.branch_misses, cache_misses - other.cache_misses,
+        time_enabled - other.time_enabled, time_running - other.time_running
+    };
+}
+
+PerfSample PerfSample::scaledToEnabledTime() const
+{
+    if (time_running == time_enabled)
+    {
+        return *this;
+    }
+
+    // Never scheduled: nothing to extrapolate from, the interval is left uncounted
+    if (time_running == 0)
+    {
+        return { 0, 0, 0, 0, time_enabled, time_enabled };
+    }
+    double scale = double(time_enabled) / double(time_running);
+    auto scaled = [scale](std::uint64_t value)
+    {
+        return std::uint64_t(double(value) * scale);
+    };
+    return {
+        scaled(cycles), scaled(instructions), scaled(branch_misses), scaled(cache_misses),
+        time_enabled, time_enabled
+    };
+}
+
+PerfCounters::PerfCounters()
+{
+#if defined(__linux__)
+    // The group leader counts the cycles, the order is the order of PerfSample
+    group_fd = openCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (group_fd == -1)
+    {
+        return;
+    }
+    for (std::uint64_t config: { PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES })
+    {
+        int fd = openCounter(config, group_fd);
+        if (fd == -1)
+        {
+            for (int member_fd: member_fds)
+            {
+                close(member_fd);
+            }
+            member_fds.clear();
+            close(group_fd);
+            group_fd = -1;
+            return;
+        }
+        member_fds.push_back(fd);
+    }
+    ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(__linux__)
+    for (int fd: member_fds)
+    {
+        close(fd);
+    }
+    if (group_fd != -1)
+    {
+        close(group_fd);
+    }
+#endif
+}
+
+bool PerfCounters::isAvailable() const
+{
+    return group_fd != -1;
+}
+
+PerfSample PerfCounters::read() const
+{
+    PerfSample sample;
+#if defined(__linux__)
+    struct
+    {
+        std::uint64_t counters_count;
+        std::uint64_t time_enabled;
+        std::uint64_t time_running;
+        std::uint64_t values[4];
+    } group { };
+    if (group_fd != -1 && ::read(group_fd, &group, sizeof(group)) == ssize_t(sizeof(group)))
+    {
+        sample = { group.values[0], group.values[1], group.values[2], group.values[3],
+                   group.time_enabled, group.time_running };
+    }
+#endif
+    return sample;
+}
+
+PerfProfiler& PerfProfiler::get()
+{
+    static PerfProfiler profiler;
+    return profiler;
+}
+
+void PerfProfiler::enable()
+{
+    is_available = threadCounters().isAvailable();
+    currentThreadTotals().is_main = true;
+    is_enabled.store(true, std::memory_order_relaxed);
+}
+
+bool PerfProfiler::isEnabled() const
+{
+    return is_enabled.load(std::memory_order_relaxed);
+}
+
+void PerfProfiler::report(std::ostream& out)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    if (!is_available)
+    {
+        out << "Hardware counters are unavailable (not Linux, or perf_event_paranoid forbids them), busy time only\n";
+    }
+    out << std::format("{:>20} | {:>9} | {:>6} | {:>9} | {:>6} | {:>10} | {:>10} | {:>5} | {:>11} | {:>11}\n",
+                       "phase", "thread", "tasks", "busy, ms", "busy %", "Mcycles", "Minstr", "IPC",
+                       "br-miss/ki", "cache-miss/ki");
+
+    auto printRow = [&out](std::string const& phase, std::string const& thread, Totals const& totals,
+                           double wall_ms)
+    {
+        PerfSample const& counters = totals.counters;
+        out << std::format("{:>20} | {:>9} | {:>6} | {:>9.2f} | {:>6.1f} | {:>10.2f} | {:>10.2f} | {:>5.2f} | {:>11.2f} | {:>11.2f}\n",
+                           phase, thread, totals.tasks_count, totals.busy_time.count(),
+                           wall_ms > 0 ? 100 * totals.busy_time.count() / wall_ms : 0.0,
+                           double(counters.cycles) / 1e6, double(counters.instructions) / 1e6,
+                           counters.cycles ? double(counters.instructions) / double(counters.cycles) : 0.0,
+                           perKiloInstructions(counters.branch_misses, counters.instructions),
+                           perKiloInstructions(counters.cache_misses, counters.instructions));
+    };
+
+    for (std::size_t phase = 0; phase != phases.size(); ++phase)
+    {
+        Totals phase_totals;
+        std::size_t threads_with_tasks = 0;
+        for (std::size_t thread = 0; thread != threads.size(); ++thread)
+        {
+            std::vector<Totals> const& by_phase = threads[thread]->by_phase;
+            if (phase >= by_phase.size() || by_phase[phase].tasks_count == 0)
+            {
+                continue;
+            }
+            Totals const& totals = by_phase[phase];
+            printRow(phases[phase].name, threads[thread]->is_main ? "main" : std::format("thread {}", thread),
+                     totals, phases[phase].wall_time.count());
+            phase_totals.counters += totals.counters;
+            phase_totals.tasks_count += totals.tasks_count;
+            phase_totals.busy_time += totals.busy_time;
+            ++threads_with_tasks;
+        }
+
+        // Busy share of all the threads of the pool: the rest is waiting for tasks
+        if (threads_with_tasks > 1)
+        {
+            printRow(phases[phase].name, "all", phase_totals,
+                     phases[phase].wall_time.count() * double(std::max<std::size_t>(phases[phase].threads_count, 1)));
+        }
+    }
+}
+
+std::size_t PerfProfiler::callingThreadPhase()
+{
+    return mutableCallingThreadPhase();
+}
+
+std::size_t& PerfProfiler::mutableCallingThreadPhase()
+{
+    thread_local std::size_t phase = 0;
+    return phase;
+}
+
+PerfProfiler::TaskStart PerfProfiler::startTask(std::size_t phase)
+{
+    return { phase, threadCounters().read(), std::chrono::steady_clock::now() };
+}
+
+void PerfProfiler::finishTask(TaskStart const& start)
+{
+    auto end = std::chrono::steady_clock::now();
+    PerfSample counters = (threadCounters().read() - start.counters).scaledToEnabledTime();
+
+    std::vector<Totals>& by_phase = currentThreadTotals().by_phase;
+    if (start.phase >= by_phase.size())
+    {
+        by_phase.resize(start.phase + 1);
+    }
+    Totals& totals = by_phase[start.phase];
+    totals.counters += counters;
+    ++totals.tasks_count;
+    totals.busy_time += end - start.time;
+}
+
+PerfProfiler::ThreadTotals& PerfProfiler::currentThreadTotals()
+{
+    thread_local ThreadTotals* thread_totals = nullptr;
+    if (!thread_totals)
+    {
+        std::lock_guard lock(mutex);
+        thread_totals = threads.emplace_back(std::make_unique<ThreadTotals>()).get();
+    }
+    return *thread_totals;
+}
+
+std::size_t PerfProfiler::enterPhase(std::string const& inner_name, std::size_t outer_phase)
+{
+    std::lock_guard lock(mutex);
+    std::string name = outer_phase == 0 ? inner_name : phases[outer_phase].name + " > " + inner_name;
+    std::size_t phase = 0;
+    while (phase != phases.size() && phases[phase].name != name)
+    {
+        ++phase;
+    }
+    if (phase == phases.size())
+    {
+        phases.push_back(Phase { name });
+    }
+    mutableCallingThreadPhase() = phase;
+    return phase;
+}
+
+void PerfProfiler::leavePhase(std::size_t phase, std::size_t previous_phase,
+                              std::chrono::duration<double, std::milli> wall_time, std::size_t threads_count)
+{
+    std::lock_guard lock(mutex);
+    phases[phase].wall_time += wall_time;
+    phases[phase].threads_count = std::max(phases[phase].threads_count, threads_count);
+    mutableCallingThreadPhase() = previous_phase;
+}
+
+PerfPhase::PerfPhase(std::string const& name, bool is_calling_thread_measured)
+    : phase { 0 }
+    , previous_phase { 0 }
+    , is_active { PerfProfiler::get().isEnabled() }
+    , is_calling_thread_measured { is_calling_thread_measured }
+{
+    PerfProfiler& profiler = PerfProfiler::get();
+    if (!is_active)
+    {
+        return;
+    }
+    previous_phase = PerfProfiler::callingThreadPhase();
+    phase = profiler.enterPhase(name, previous_phase);
+    begin = std::chrono::steady_clock::now();
+    if (is_calling_thread_measured)
+    {
+        calling_thread_start = profiler.startTask(phase);
+    }
+}
+
+PerfPhase::~PerfPhase()
+{
+    PerfProfiler& profiler = PerfProfiler::get();
+    if (!is_active)
+    {
+        return;
+    }
+    if (is_calling_thread_measured)
+    {
+        profiler.finishTask(calling_thread_start);
+    }
+    std::size_t threads_count = is_calling_thread_measured ? 1 : ThreadPoolSimpleInstance::get().threadsCount();
+    profiler.leavePhase(phase, previous_phase, std::chrono::steady_clock::now() - begin, threads_count);
+}
@@ -0,0 +1,156 @@
+#ifndef MANDELBROT_CPP_PERFPROFILER_H
+#define MANDELBROT_CPP_PERFPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct PerfSample
+{
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t branch_misses = 0;
+    std::uint64_t cache_misses = 0;
+
+    // Nanoseconds the group was enabled and actually counting: less when the kernel multiplexed it
+    // with other events because the PMU was short of counters
+    std::uint64_t time_enabled = 0;
+    std::uint64_t time_running = 0;
+
+    PerfSample& operator +=(PerfSample const& other);
+    PerfSample operator -(PerfSample const& other) const;
+
+    // Counts extrapolated from the running time to the enabled time
+    [[nodiscard]] PerfSample scaledToEnabledTime() const;
+};
+
+// Hardware counters of the calling thread, user space only, opened as one perf_event_open group.
+// Linux only: elsewhere or when the kernel refuses (perf_event_paranoid, containers) they are unavailable
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator =(PerfCounters const&) = delete;
+
+    [[nodiscard]] bool isAvailable() const;
+
+    // Counted since the opening, not scaled: scale the difference of two reads
+    [[nodiscard]] PerfSample read() const;
+
+private:
+    int group_fd = -1;
+    std::vector<int> member_fds;
+};
+
+// Counters and busy time of the thread pool tasks per phase (a calc method, a benchmark step) and per thread.
+// Off by default, then a task costs one relaxed load
+class PerfProfiler
+{
+public:
+    static PerfProfiler& get();
+
+    // The calling thread is reported as the main one
+    void enable();
+
+    [[nodiscard]] bool isEnabled() const;
+
+    // Phase opened by the calling thread. The thread pool attributes the tasks of a batch to the phase of
+    // the thread that adds it, not to the phase current when a task starts
+    [[nodiscard]] static std::size_t callingThreadPhase();
+
+    template<class Task>
+    void measure(Task&& task, std::size_t phase)
+    {
+        if (!is_enabled.load(std::memory_order_relaxed))
+        {
+            task();
+            return;
+        }
+        TaskStart start = startTask(phase);
+        task();
+        finishTask(start);
+    }
+
+    // Per phase and thread: cycles, instructions, IPC, branch and cache misses per 1000 instructions,
+    // and the busy share of the phase wall time. Nothing when disabled. Call while the pool is idle
+    void report(std::ostream& out);
+
+private:
+    friend class PerfPhase;
+
+    struct Totals
+    {
+        PerfSample counters;
+        std::size_t tasks_count = 0;
+        std::chrono::duration<double, std::milli> busy_time { };
+    };
+
+    struct ThreadTotals
+    {
+        bool is_main = false;
+        std::vector<Totals> by_phase;
+    };
+
+    struct Phase
+    {
+        std::string name;
+        std::chrono::duration<double, std::milli> wall_time { };
+        std::size_t threads_count = 0;
+    };
+
+    struct TaskStart
+    {
+        std::size_t phase;
+        PerfSample counters;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    TaskStart startTask(std::size_t phase);
+    void finishTask(TaskStart const& start);
+
+    ThreadTotals& currentThreadTotals();
+
+    static std::size_t& mutableCallingThreadPhase();
+
+    std::size_t enterPhase(std::string const& name, std::size_t outer_phase);
+    void leavePhase(std::size_t phase, std::size_t previous_phase, std::chrono::duration<double, std::milli> wall_time,
+                    std::size_t threads_count);
+
+private:
+    std::atomic<bool> is_enabled = false;
+    std::mutex mutex;
+    std::vector<Phase> phases { Phase { "other" }};
+    std::vector<std::unique_ptr<ThreadTotals>> threads;
+    bool is_available = false;
+};
+
+// Attributes the thread pool tasks added meanwhile by the calling thread to the phase, phases of the same name add up.
+// A phase opened inside another one is named "outer > inner", e.g. a replay action and its calc method.
+// A single-threaded kernel run by the calling thread itself is measured as one task of the whole scope
+class PerfPhase
+{
+public:
+    explicit PerfPhase(std::string const& name, bool is_calling_thread_measured = false);
+    ~PerfPhase();
+
+    PerfPhase(PerfPhase const&) = delete;
+    PerfPhase& operator =(PerfPhase const&) = delete;
+
+private:
+    std::size_t phase;
+    std::size_t previous_phase;
+    bool is_active;
+    bool is_calling_thread_measured;
+    PerfProfiler::TaskStart calling_thread_start;
+    std::chrono::steady_clock::time_point begin;
+};
+
+#endif //MANDELBROT_CPP_PERFPROFILER_H
@@ -5,7 +5,18 @@
 #include <functional>
 #include <mutex>
 #include <queue>
+#include <algorithm>
 #include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <format>
+#include <iostream>
+#include "CompletionLatch.h"
+#include "CpuTopology.h"
+#include "ThreadPoolConfig.h"
+#include "PerfProfiler.h"
 
 template<class Result>
 class TaskPool
@@ -13,30 +24,104 @@ class TaskPool
 public:
     using CallableTask = std::function<Result()>;
 
-    template<class TasksIterator>
-    void add(TasksIterator tasks_iterator)
+    static constexpr std::size_t shared_group = std::numeric_limits<std::size_t>::max();
+
+    struct QueuedTask
+    {
+        explicit operator bool() const
+        {
+            return static_cast<bool>(task);
+        }
+
+        CallableTask task;
+        std::shared_ptr<CompletionLatch> batch_latch;
+
+        // Of the thread that added the batch
+        std::size_t perf_phase = 0;
+    };
+
+    // A thread takes its group queue first, then the shared queue, then the queues of the other groups
+    void setGroupsCount(std::size_t groups_count)
     {
+        std::lock_guard lock(mutex);
+        group_queues.resize(groups_count);
+    }
+
+    // Task i goes to the queue of group_of_task(i), to the shared queue for shared_group
+    template<class TasksIterator, class GroupOfTask>
+    void add(TasksIterator tasks_iterator, std::shared_ptr<CompletionLatch> const& batch_latch,
+             GroupOfTask group_of_task)
+    {
+        std::size_t perf_phase = PerfProfiler::callingThreadPhase();
         {
             std::lock_guard lock(mutex);
+            std::size_t tasks_count = 0;
             do
             {
-                task_queue.push(*tasks_iterator);
+                std::size_t group = group_of_task(int(tasks_count));
+                std::queue<QueuedTask>& queue = group < group_queues.size() ? group_queues[group] : task_queue;
+                queue.push(QueuedTask { *tasks_iterator, batch_latch, perf_phase });
+                ++tasks_count;
             } while (++tasks_iterator);
+
+            // Counted before unlock, so no task can finish before it is accounted
+            batch_latch->countUp(tasks_count);
+            all_tasks_latch.countUp(tasks_count);
         }
         notifyAll();
     }
 
-    CallableTask getTask()
+    // The tasks of the group first. A thread whose group ran out of tasks takes them from the other groups
+    // rather than parks while they finish their tails
+    QueuedTask getTask(std::size_t group)
     {
-        CallableTask task;
-        if (std::lock_guard lock(mutex); !task_queue.empty())
+        QueuedTask task;
+        std::lock_guard lock(mutex);
+        std::queue<QueuedTask>* queue = &group_queues[group];
+        if (queue->empty())
+        {
+            queue = &task_queue;
+        }
+        for (std::size_t i = 1; queue->empty() && i != group_queues.size(); ++i)
         {
-            task = task_queue.front();
-            task_queue.pop();
+            queue = &group_queues[(group + i) % group_queues.size()];
+        }
+        if (!queue->empty())
+        {
+            task = std::move(queue->front());
+            queue->pop();
         }
         return task;
     }
 
+    void finishTask(QueuedTask& task)
+    {
+        bool is_batch_released = task.batch_latch->countDown();
+        all_tasks_latch.countDown();
+        if (is_batch_released)
+        {
+            notifyMainThread();
+        }
+    }
+
+    // Wakes the main thread parked in waitForMainThreadSignal
+    void notifyMainThread()
+    {
+        main_thread_signal.fetch_add(1, std::memory_order_release);
+        main_thread_signal.notify_one();
+    }
+
+    [[nodiscard]] std::uint32_t mainThreadSignal() const
+    {
+        return main_thread_signal.load(std::memory_order_acquire);
+    }
+
+    // Until the signal differs from the seen one
+    void waitForMainThreadSignal(std::uint32_t seen_signal) const
+    {
+        main_thread_signal.wait(seen_signal, std::memory_order_acquire);
+    }
+
     void notifyAll()
     {
         condition_variable.notify_all();
@@ -45,20 +130,50 @@ public:
     bool isEmpty()
     {
         std::lock_guard lock(mutex);
-        return task_queue.empty();
+        return isEmptyLocked();
     }
 
-    void waitForTasks(bool const& is_program_work)
+    [[nodiscard]] bool isWorking() const
+    {
+        return is_working.load(std::memory_order_acquire);
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard lock(mutex);
+            is_working.store(false, std::memory_order_release);
+        }
+        notifyAll();
+    }
+
+    // Any queue wakes the thread, since it takes the tasks of the other groups too
+    void waitForTasks()
     {
         std::unique_lock lock(mutex);
         condition_variable.wait(lock, [&]
-        { return !task_queue.empty() || !is_program_work; });
+        { return !isEmptyLocked() || !isWorking(); });
+    }
+
+    CompletionLatch const& allTasksLatch() const
+    {
+        return all_tasks_latch;
     }
 
 private:
-    std::queue<CallableTask> task_queue;
+    bool isEmptyLocked() const
+    {
+        return task_queue.empty() && std::all_of(group_queues.begin(), group_queues.end(), [](auto const& queue)
+        { return queue.empty(); });
+    }
+
+    std::queue<QueuedTask> task_queue;
+    std::vector<std::queue<QueuedTask>> group_queues = std::vector<std::queue<QueuedTask>>(1);
     std::mutex mutex;
     std::condition_variable condition_variable;
+    std::atomic<bool> is_working = true;
+    CompletionLatch all_tasks_latch;
+    std::atomic<std::uint32_t> main_thread_signal = 0;
 };
 
 template<class Result, class Worker, bool is_result_void>
@@ -66,9 +181,9 @@ class WorkerHelper
 {
 public:
     template<class Task>
-    void runTask(Task task)
+    void runTask(Task task, std::size_t perf_phase)
     {
-        task();
+        PerfProfiler::get().measure(task, perf_phase);
     }
 };
 
@@ -77,9 +192,12 @@ class WorkerHelper<Result, Worker, false>
 {
 public:
     template<class Task>
-    void runTask(Task task)
+    void runTask(Task task, std::size_t perf_phase)
     {
-        finished_work.push_back(std::move(task()));
+        PerfProfiler::get().measure([this, &task]
+        {
+            finished_work.push_back(std::move(task()));
+        }, perf_phase);
     }
 
     auto getResults()
@@ -101,8 +219,8 @@ public:
     Worker() = default;
     Worker(const Worker&) = delete;
 
-    Worker(bool const& is_program_work, TaskPool<Result>& task_pool)
-        : thread(&Worker::workParallel, this, std::ref(is_program_work), std::ref(task_pool))
+    Worker(TaskPool<Result>& task_pool, std::vector<int> cpus, std::size_t group)
+        : thread(&Worker::workParallel, this, std::ref(task_pool), std::move(cpus), group)
     { }
 
     ~Worker()
@@ -111,43 +229,47 @@ public:
         { thread.join(); }
     }
 
-    void workMain(TaskPool<Result>& task_pool)
+    void workMain(TaskPool<Result>& task_pool, CompletionLatch const& batch_latch,
+                  std::function<void()> const& idle_work = { })
     {
-        typename TaskPool<Result>::CallableTask task;
-        while ((task = task_pool.getTask()))
+        typename TaskPool<Result>::QueuedTask task;
+        while (!batch_latch.isReleased() && (task = task_pool.getTask(main_thread_group)))
         {
-            this->runTask(task);
+            this->runTask(task.task, task.perf_phase);
+            task_pool.finishTask(task);
+            if (idle_work)
+            {
+                idle_work();
+            }
         }
-
-    }
-
-    [[nodiscard]] bool done() const
-    {
-        return done_work;
     }
 
 private:
-    void workParallel(bool const& is_program_work, TaskPool<Result>& task_pool)
+    void workParallel(TaskPool<Result>& task_pool, std::vector<int> const& cpus, std::size_t group)
     {
-        while (is_program_work)
+        if (!pinCurrentThreadToCpus(cpus))
         {
-            typename TaskPool<Result>::CallableTask task = task_pool.getTask();
+            std::clog << std::format("Can't pin a worker to the CPUs {}, the OS schedules it\n", formatCpuList(cpus));
+        }
+        while (task_pool.isWorking())
+        {
+            typename TaskPool<Result>::QueuedTask task = task_pool.getTask(group);
             if (task)
             {
-                this->runTask(task);
+                this->runTask(task.task, task.perf_phase);
+                task_pool.finishTask(task);
             }
             else
             {
-                done_work = true;
-                task_pool.waitForTasks(is_program_work);
-                done_work = false;
+                task_pool.waitForTasks();
             }
         }
     }
 
 private:
+    static constexpr std::size_t main_thread_group = 0;
+
     std::thread thread;
-    std::atomic<bool> done_work = true;
 };
 
 template<class TaskResultT>
@@ -155,54 +277,165 @@ class ThreadPool
 {
     using WorkerT = Worker<TaskResultT>;
 public:
-    ThreadPool()
+    explicit ThreadPool(ThreadPoolConfig const& config = { })
     {
-        for (size_t i = 0; i != std::thread::hardware_concurrency() - 1; ++i)
+        // hardware_concurrency() is allowed to return 0
+        std::size_t workers_count = config.workers_count.value_or(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+
+        // Pinned workers are grouped by their NUMA nodes, the main thread makes group 0 with the workers of its node.
+        // The pool is created by the main thread that joins the workers, so it is pinned here: to main_thread_cpus,
+        // or to the CPUs of the node of the first worker
+        std::vector<std::size_t> worker_groups(workers_count, 0);
+        group_threads_counts = { 1 };
+        CpuTopology topology = CpuTopology::detect();
+        topology.checkCpus(config.cpu_affinity);
+        topology.checkCpus(config.main_thread_cpus);
+        pinMainThread(config.main_thread_cpus);
+        if (!config.cpu_affinity.empty() && workers_count != 0)
         {
-            workers.push_back(std::make_unique<WorkerT>(is_program_work, task_pool));
+            std::size_t main_thread_node = topology.nodeOf(config.main_thread_cpus.empty() ? config.cpu_affinity[0]
+                                                                                           : config.main_thread_cpus[0]);
+            if (config.main_thread_cpus.empty())
+            {
+                pinMainThread(topology.node_cpus[main_thread_node]);
+            }
+            std::vector<std::size_t> group_of_node(topology.node_cpus.size(), TaskPool<TaskResultT>::shared_group);
+            group_of_node[main_thread_node] = 0;
+            for (std::size_t i = 0; i != workers_count; ++i)
+            {
+                std::size_t node = topology.nodeOf(config.cpu_affinity[i % config.cpu_affinity.size()]);
+                if (group_of_node[node] == TaskPool<TaskResultT>::shared_group)
+                {
+                    group_of_node[node] = group_threads_counts.size();
+                    group_threads_counts.push_back(0);
+                }
+                worker_groups[i] = group_of_node[node];
+            }
+        }
+        task_pool.setGroupsCount(group_threads_counts.size());
+
+        for (size_t i = 0; i != workers_count; ++i)
+        {
+            std::vector<int> cpus;
+            if (!config.cpu_affinity.empty())
+            {
+                cpus.push_back(config.cpu_affinity[i % config.cpu_affinity.size()]);
+            }
+            ++group_threads_counts[worker_groups[i]];
+            workers.push_back(std::make_unique<WorkerT>(task_pool, std::move(cpus), worker_groups[i]));
         }
     }
 
     ~ThreadPool()
     {
-        is_program_work = false;
-        task_pool.notifyAll();
+        task_pool.shutdown();
         workers.clear();
     }
 
+    // Returns the latch of the added batch: it is released when the last task of the batch is finished
     template<class TasksIterator>
-    void addTasks(TasksIterator task_iterator)
+    std::shared_ptr<CompletionLatch> addTasks(TasksIterator task_iterator)
     {
+        return addTasks(task_iterator, [](int)
+        { return TaskPool<TaskResultT>::shared_group; });
+    }
+
+    // Task i runs only on the threads of the group group_of_task(i), e.g. groupOfRow() of the rows it writes
+    template<class TasksIterator, class GroupOfTask>
+    std::shared_ptr<CompletionLatch> addTasks(TasksIterator task_iterator, GroupOfTask group_of_task)
+    {
+        auto batch_latch = std::make_shared<CompletionLatch>();
         if (!task_iterator)
         {
-            return;
+            return batch_latch;
         }
-        task_pool.add(task_iterator);
+        task_pool.add(task_iterator, batch_latch, group_of_task);
+        return batch_latch;
     }
 
-    void joinMainToWorkers()
+    // Rows are split into contiguous ranges, one per thread group and sized by its threads count.
+    // The group of a range takes its rows first, so they mostly stay in the memory of its NUMA node;
+    // an idle group takes the rest of the other ranges
+    [[nodiscard]] std::size_t groupOfRow(int row, int rows_count) const
     {
-        worker_from_main_thread.workMain(task_pool);
+        std::size_t position = std::size_t(row) * threadsCount() / std::size_t(std::max(rows_count, 1));
+        std::size_t group = 0;
+        std::size_t threads = group_threads_counts[0];
+        while (position >= threads && group + 1 != group_threads_counts.size())
+        {
+            threads += group_threads_counts[++group];
+        }
+        return group;
     }
 
-    bool IsWorkDone()
+    // Main thread helps the workers with the queue and then waits until the batch is finished
+    void joinMainToWorkers(CompletionLatch const& batch_latch)
     {
-        bool work_done = task_pool.isEmpty();
-        for (std::unique_ptr<Worker<TaskResultT>> const& w: workers)
+        if (!main_thread_idle_work || main_thread_id != std::this_thread::get_id())
+        {
+            worker_from_main_thread.workMain(task_pool, batch_latch);
+            batch_latch.wait();
+            return;
+        }
+
+        // The idle work runs only after a signal: results published by notifyMainThread() or a released batch.
+        // Between the signals the main thread is parked
+        std::uint32_t seen_signal = task_pool.mainThreadSignal();
+        auto runIdleWorkWhenSignaled = [this, &seen_signal]
+        {
+            std::uint32_t signal = task_pool.mainThreadSignal();
+            if (signal != seen_signal)
+            {
+                seen_signal = signal;
+                main_thread_idle_work();
+            }
+        };
+        worker_from_main_thread.workMain(task_pool, batch_latch, runIdleWorkWhenSignaled);
+        while (true)
         {
-            if (work_done &= w->done(); !work_done)
+            runIdleWorkWhenSignaled();
+            if (batch_latch.isReleased())
             {
-                break;
+                return;
             }
+            task_pool.waitForMainThreadSignal(seen_signal);
         }
-        return work_done;
+    }
+
+    // Results for the main thread idle work are ready
+    void notifyMainThread()
+    {
+        task_pool.notifyMainThread();
+    }
+
+    // Runs on the calling thread whenever it joins the workers: between its own tasks and while it waits for
+    // the batch, each time after notifyMainThread(). E.g. to consume finished results. Empty function to remove
+    void setMainThreadIdleWork(std::function<void()> idle_work)
+    {
+        main_thread_idle_work = std::move(idle_work);
+        main_thread_id = std::this_thread::get_id();
+    }
+
+    void joinMainToWorkers()
+    {
+        joinMainToWorkers(task_pool.allTasksLatch());
+    }
+
+    // Workers and the main thread that joins them
+    [[nodiscard]] std::size_t threadsCount() const
+    {
+        return workers.size() + 1;
+    }
+
+    bool IsWorkDone()
+    {
+        return task_pool.allTasksLatch().isReleased();
     }
 
     template<class ResultHandler>
     void handleResults(ResultHandler result_handler)
     {
-        while (!IsWorkDone())
-        { }
+        task_pool.allTasksLatch().wait();
         for (auto& worker: workers)
         {
             for (auto& result: worker->getResults())
@@ -213,10 +446,22 @@ public:
     }
 
 private:
-    bool is_program_work = true;
+    static void pinMainThread(std::vector<int> const& cpus)
+    {
+        if (!pinCurrentThreadToCpus(cpus))
+        {
+            std::clog << std::format("Can't pin the main thread to the CPUs {}, the OS schedules it\n", formatCpuList(cpus));
+        }
+    }
+
     TaskPool<TaskResultT> task_pool;
     std::vector<std::unique_ptr<WorkerT>> workers;
     Worker<TaskResultT> worker_from_main_thread;
+    std::function<void()> main_thread_idle_work;
+    std::thread::id main_thread_id;
+
+    // Threads of each group, the main thread is counted in group 0
+    std::vector<std::size_t> group_threads_counts;
 };
 
 #endif //MANDELBROT_CPP_THREADPOOL_H
@@ -0,0 +1,22 @@
+#ifndef MANDELBROT_CPP_THREADPOOLCONFIG_H
+#define MANDELBROT_CPP_THREADPOOLCONFIG_H
+
+#include <vector>
+#include <cstddef>
+#include <optional>
+
+struct ThreadPoolConfig
+{
+    // Empty - one worker per hardware thread, except the main thread that joins the workers.
+    // 0 - no workers, the main thread runs every task
+    std::optional<std::size_t> workers_count;
+
+    // Worker i is pinned to cpu_affinity[i % size]. Empty - the OS schedules the workers
+    std::vector<int> cpu_affinity;
+
+    // CPUs of the main thread that joins the workers. Empty - the CPUs of the node of the first pinned worker,
+    // or the affinity it already has if the workers aren't pinned
+    std::vector<int> main_thread_cpus;
+};
+
+#endif //MANDELBROT_CPP_THREADPOOLCONFIG_H
@@ -11,7 +11,20 @@ public:
 
     static ThreadPool<TaskResult>& get()
     {
-        static ThreadPool<TaskResult> thread_pool;
+        return *instance();
+    }
+
+    // Recreates the pool. Must not be called while the pool has tasks in flight
+    static void configure(ThreadPoolConfig const& config)
+    {
+        instance().reset();
+        instance() = std::make_unique<ThreadPool<TaskResult>>(config);
+    }
+
+private:
+    static std::unique_ptr<ThreadPool<TaskResult>>& instance()
+    {
+        static std::unique_ptr<ThreadPool<TaskResult>> thread_pool = std::make_unique<ThreadPool<TaskResult>>();
         return thread_pool;
     }
 };
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <format>
+#include <limits>
+#include "PosterRenderer.h"
+#include "../Fractal/TaskIterators.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+
+namespace
+{
+    // Tiles between two progress lines
+    constexpr std::size_t progress_tiles_count = 64;
+}
+
+PosterRenderer::PosterRenderer(ProgramConfig const& program_config)
+    : config { program_config.poster_config }
+    , calc_method { program_config.calc_method }
+    , color_table { program_config.color_table_config }
+    , axis { program_config.axis.cartesian_borders,
+             PlaneBorders<int> { MinMax<int> { 0, int(config.width) }, MinMax<int> { 0, int(config.height) }}}
+    , tiles_x { (config.width + config.tile_size - 1) / config.tile_size }
+    , tiles_y { (config.height + config.tile_size - 1) / config.tile_size }
+{
+    image.create(config.width, config.height);
+}
+
+void PosterRenderer::render(std::string const& image_path, std::ostream& log)
+{
+    std::string journal_path = image_path + ".journal";
+    renderTiles(journal_path, log);
+    if (!image.saveToFile(image_path))
+    {
+        throw std::runtime_error("Can't write " + image_path);
+    }
+    std::filesystem::remove(journal_path);
+}
+
+void PosterRenderer::renderTiles(std::string const& journal_path, std::ostream& log)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    // The precision tier of the poster pixels, not of the last frame of a tiered calc method
+    FractalCalcMethod const& poster_calc_method = calc_method->methodForPixelSize(axis.pixelSize());
+    RenderJournal::Header header {
+        config.width, config.height, config.tile_size, config.iterations_count,
+        axis.cartesian_borders.x.min, axis.cartesian_borders.x.max,
+        axis.cartesian_borders.y.min, axis.cartesian_borders.y.max,
+        poster_calc_method.name(), poster_calc_method.formulaName()
+    };
+
+    std::uint32_t tiles_count = tiles_x * tiles_y;
+    std::vector<bool> is_tile_finished(tiles_count, false);
+    auto restoreTile = [this, &is_tile_finished](std::uint32_t tile_index, std::vector<std::uint32_t> const& escape_times)
+    {
+        if (escape_times.size() == std::size_t(tileRect(tile_index).width) * std::size_t(tileRect(tile_index).height))
+        {
+            drawTile(tile_index, escape_times);
+            is_tile_finished[tile_index] = true;
+        }
+    };
+    RenderJournal journal(journal_path, header, config.sync_interval, restoreTile);
+
+    std::vector<std::uint32_t> missing_tiles;
+    for (std::uint32_t tile_index = 0; tile_index != tiles_count; ++tile_index)
+    {
+        if (!is_tile_finished[tile_index])
+        {
+            missing_tiles.push_back(tile_index);
+        }
+    }
+    auto restore_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin);
+    log << std::format("Poster {}x{}: {} of {} tiles restored from {} in {:.2f} s\n", config.width, config.height,
+                       tiles_count - missing_tiles.size(), tiles_count, journal_path, restore_time.count());
+
+    auto render_begin = std::chrono::steady_clock::now();
+    std::atomic<std::size_t> rendered_count = 0;
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto tile_task = [this, &poster_calc_method, &journal, &missing_tiles, &rendered_count, &thread_pool](int task)
+    {
+        std::uint32_t tile_index = missing_tiles[std::size_t(task)];
+        sf::IntRect rect = tileRect(tile_index);
+        std::vector<std::uint32_t> escape_times;
+        escape_times.reserve(std::size_t(rect.width) * std::size_t(rect.height));
+        for (int py = rect.top; py != rect.top + rect.height; ++py)
+        {
+            for (int px = rect.left; px != rect.left + rect.width; ++px)
+            {
+                Complex c { axis.screenToCartesianX(px), axis.screenToCartesianY(py) };
+                std::size_t spent_iterations = poster_calc_method.calcPoint(config.iterations_count, c);
+                escape_times.push_back(spent_iterations == std::numeric_limits<std::size_t>::max()
+                                       ? RenderJournal::in_set_escape_time
+                                       : std::uint32_t(std::min<std::size_t>(spent_iterations,
+                                                                             RenderJournal::in_set_escape_time - 1)));
+            }
+        }
+        drawTile(tile_index, escape_times);
+        journal.append(tile_index, escape_times);
+
+        if (++rendered_count % progress_tiles_count == 0)
+        {
+            thread_pool.notifyMainThread();
+        }
+    };
+
+    // The progress is written by the main thread alone, the workers only signal it
+    std::size_t reported_count = 0;
+    thread_pool.setMainThreadIdleWork([&rendered_count, &reported_count, &missing_tiles, &log]
+    {
+        std::size_t rendered = rendered_count / progress_tiles_count * progress_tiles_count;
+        if (rendered > reported_count)
+        {
+            reported_count = rendered;
+            log << std::format("{} of {} tiles\n", rendered, missing_tiles.size());
+        }
+    });
+    auto tiles_latch = thread_pool.addTasks(RowTasksIterator<decltype(tile_task)> { tile_task, int(missing_tiles.size()) });
+    thread_pool.joinMainToWorkers(*tiles_latch);
+    thread_pool.setMainThreadIdleWork({ });
+    journal.sync();
+    auto render_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - render_begin);
+    log << std::format("{} tiles rendered in {:.2f} s, checkpoints took {:.3f} s ({:.2f}%)\n", missing_tiles.size(),
+                       render_time.count(), journal.spentTime().count(),
+                       render_time.count() > 0 ? 100 * journal.spentTime().count() / render_time.count() : 0.0);
+}
+
+sf::IntRect PosterRenderer::tileRect(std::uint32_t tile_index) const
+{
+    auto left = int(tile_index % tiles_x * config.tile_size);
+    auto top = int(tile_index / tiles_x * config.tile_size);
+    return {
+        left, top,
+        std::min(int(config.tile_size), int(config.width) - left),
+        std::min(int(config.tile_size), int(config.height) - top)
+    };
+}
+
+void PosterRenderer::drawTile(std::uint32_t tile_index, std::vector<std::uint32_t> const& escape_times)
+{
+    sf::IntRect rect = tileRect(tile_index);
+    std::size_t i = 0;
+    for (int py = rect.top; py != rect.top + rect.height; ++py)
+    {
+        for (int px = rect.left; px != rect.left + rect.width; ++px)
+        {
+            std::uint32_t escape_time = escape_times[i++];
+            std::size_t spent_iterations = escape_time == RenderJournal::in_set_escape_time
+                                           ? std::numeric_limits<std::size_t>::max()
+                                           : escape_time;
+            image.setPixel(unsigned(px), unsigned(py), color_table.colorOf(spent_iterations));
+        }
+    }
+}
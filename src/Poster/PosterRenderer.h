@@ -0,0 +1,38 @@
+#ifndef MANDELBROT_CPP_POSTERRENDERER_H
+#define MANDELBROT_CPP_POSTERRENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <ostream>
+#include <string>
+#include "RenderJournal.h"
+#include "../Fractal/Config.h"
+#include "../Fractal/ColorTable.h"
+
+// Renders the start view into a large image, one thread pool task per tile.
+// Finished tiles are appended to "<image>.journal", so a rerun after a crash recolors the journaled tiles
+// and computes only the missing ones. The journal is removed once the image is saved
+class PosterRenderer
+{
+public:
+    explicit PosterRenderer(ProgramConfig const& program_config);
+
+    void render(std::string const& image_path, std::ostream& log);
+
+private:
+    void renderTiles(std::string const& journal_path, std::ostream& log);
+
+    [[nodiscard]] sf::IntRect tileRect(std::uint32_t tile_index) const;
+
+    void drawTile(std::uint32_t tile_index, std::vector<std::uint32_t> const& escape_times);
+
+private:
+    PosterConfig config;
+    std::shared_ptr<FractalCalcMethod> calc_method;
+    ColorTable color_table;
+    Axis axis;
+    std::uint32_t tiles_x;
+    std::uint32_t tiles_y;
+    sf::Image image;
+};
+
+#endif //MANDELBROT_CPP_POSTERRENDERER_H
@@ -0,0 +1,206 @@
+#include <filesystem>
+#include <stdexcept>
+#include "RenderJournal.h"
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr std::uint32_t journal_magic = 0x4A42'444D; // "MDBJ"
+
+    template<class T>
+    void writeValue(std::FILE* file, T const& value)
+    {
+        std::fwrite(&value, sizeof(value), 1, file);
+    }
+
+    template<class T>
+    bool readValue(std::FILE* file, T& value)
+    {
+        return std::fread(&value, sizeof(value), 1, file) == 1;
+    }
+
+    // Length, then the characters
+    void writeString(std::FILE* file, std::string const& value)
+    {
+        writeValue(file, std::uint32_t(value.size()));
+        std::fwrite(value.data(), 1, value.size(), file);
+    }
+
+    bool readString(std::FILE* file, std::string& value)
+    {
+        constexpr std::uint32_t max_size = 256;
+        std::uint32_t size;
+        if (!readValue(file, size) || size > max_size)
+        {
+            return false;
+        }
+        value.resize(size);
+        return std::fread(value.data(), 1, size, file) == size;
+    }
+
+    void flushToDisk(std::FILE* file)
+    {
+        std::fflush(file);
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+
+    // FNV-1a
+    std::uint32_t checksumOf(std::uint32_t tile_index, std::vector<std::uint32_t> const& escape_times)
+    {
+        std::uint32_t hash = 2166136261u;
+        auto mix = [&hash](std::uint32_t value)
+        {
+            hash = (hash ^ value) * 16777619u;
+        };
+        mix(tile_index);
+        for (std::uint32_t escape_time: escape_times)
+        {
+            mix(escape_time);
+        }
+        return hash;
+    }
+
+    void writeHeader(std::FILE* file, RenderJournal::Header const& header)
+    {
+        writeValue(file, journal_magic);
+        writeValue(file, header.width);
+        writeValue(file, header.height);
+        writeValue(file, header.tile_size);
+        writeValue(file, header.iterations_count);
+        for (Real border: { header.x_min, header.x_max, header.y_min, header.y_max })
+        {
+            writeValue(file, border);
+        }
+        writeString(file, header.calc_method);
+        writeString(file, header.formula);
+    }
+
+    bool isSameRender(std::FILE* file, RenderJournal::Header const& header)
+    {
+        std::uint32_t magic;
+        RenderJournal::Header read;
+        bool is_read = readValue(file, magic) && readValue(file, read.width) && readValue(file, read.height) &&
+                       readValue(file, read.tile_size) && readValue(file, read.iterations_count) &&
+                       readValue(file, read.x_min) && readValue(file, read.x_max) &&
+                       readValue(file, read.y_min) && readValue(file, read.y_max) &&
+                       readString(file, read.calc_method) && readString(file, read.formula);
+        return is_read && magic == journal_magic &&
+               read.width == header.width && read.height == header.height && read.tile_size == header.tile_size &&
+               read.iterations_count == header.iterations_count &&
+               read.x_min == header.x_min && read.x_max == header.x_max &&
+               read.y_min == header.y_min && read.y_max == header.y_max &&
+               read.calc_method == header.calc_method && read.formula == header.formula;
+    }
+}
+
+RenderJournal::RenderJournal(std::string file_path, Header const& header, std::chrono::milliseconds sync_interval,
+                             TileCallback const& callbackFinishedTile)
+    : file_path { std::move(file_path) }
+    , sync_interval { sync_interval }
+{
+    std::uintmax_t valid_size = replay(header, callbackFinishedTile);
+    if (valid_size == 0)
+    {
+        file = std::fopen(this->file_path.c_str(), "wb");
+        if (file)
+        {
+            writeHeader(file, header);
+        }
+    }
+    else
+    {
+        // Drops the torn record of the crash, the new ones are appended after the valid part
+        std::filesystem::resize_file(this->file_path, valid_size);
+        file = std::fopen(this->file_path.c_str(), "ab");
+    }
+    if (!file)
+    {
+        throw std::runtime_error("Can't write " + this->file_path);
+    }
+    sync();
+}
+
+RenderJournal::~RenderJournal()
+{
+    sync();
+    std::fclose(file);
+}
+
+void RenderJournal::append(std::uint32_t tile_index, std::vector<std::uint32_t> const& escape_times)
+{
+    auto begin = std::chrono::steady_clock::now();
+    std::lock_guard lock(file_mutex);
+    writeValue(file, tile_index);
+    writeValue(file, std::uint32_t(escape_times.size()));
+    std::fwrite(escape_times.data(), sizeof(std::uint32_t), escape_times.size(), file);
+    writeValue(file, checksumOf(tile_index, escape_times));
+
+    // Buffered writes cost little, the disk flushes are rare
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_sync >= sync_interval)
+    {
+        flushToDisk(file);
+        now = std::chrono::steady_clock::now();
+        last_sync = now;
+    }
+    spent_time += now - begin;
+}
+
+void RenderJournal::sync()
+{
+    auto begin = std::chrono::steady_clock::now();
+    std::lock_guard lock(file_mutex);
+    flushToDisk(file);
+    last_sync = std::chrono::steady_clock::now();
+    spent_time += last_sync - begin;
+}
+
+std::chrono::duration<double> RenderJournal::spentTime() const
+{
+    return spent_time;
+}
+
+std::uintmax_t RenderJournal::replay(Header const& header, TileCallback const& callbackFinishedTile)
+{
+    std::FILE* journal = std::fopen(file_path.c_str(), "rb");
+    if (!journal)
+    {
+        return 0;
+    }
+    if (!isSameRender(journal, header))
+    {
+        std::fclose(journal);
+        return 0;
+    }
+
+    std::uint32_t tiles_x = (header.width + header.tile_size - 1) / header.tile_size;
+    std::uint32_t tiles_y = (header.height + header.tile_size - 1) / header.tile_size;
+    std::uint64_t max_tile_pixels = std::uint64_t(header.tile_size) * header.tile_size;
+    auto valid_size = std::uintmax_t(std::ftell(journal));
+
+    std::vector<std::uint32_t> escape_times;
+    std::uint32_t tile_index, pixels_count, checksum;
+    while (readValue(journal, tile_index) && readValue(journal, pixels_count) &&
+           tile_index < tiles_x * tiles_y && pixels_count <= max_tile_pixels)
+    {
+        escape_times.resize(pixels_count);
+        if (std::fread(escape_times.data(), sizeof(std::uint32_t), pixels_count, journal) != pixels_count ||
+            !readValue(journal, checksum) || checksum != checksumOf(tile_index, escape_times))
+        {
+            break;
+        }
+        callbackFinishedTile(tile_index, escape_times);
+        valid_size = std::uintmax_t(std::ftell(journal));
+    }
+    std::fclose(journal);
+    return valid_size;
+}
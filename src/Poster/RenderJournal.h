@@ -0,0 +1,69 @@
+#ifndef MANDELBROT_CPP_RENDERJOURNAL_H
+#define MANDELBROT_CPP_RENDERJOURNAL_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../Utility/Types.h"
+
+// Append-only file of finished tiles: the header with the view, the render settings and the kernel, then
+// "<tile index> <pixels count> <escape times> <checksum>" records. A record cut by a crash fails the checksum
+// and is dropped together with everything after it
+class RenderJournal
+{
+public:
+    struct Header
+    {
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t tile_size;
+        std::uint64_t iterations_count;
+        Real x_min, x_max, y_min, y_max;
+
+        // As FractalCalcMethod names them: tiles of another kernel differ in the last iterations
+        std::string calc_method;
+        std::string formula;
+    };
+
+    // Escape times are 32-bit, the points of the set are stored as this value
+    static constexpr std::uint32_t in_set_escape_time = 0xFFFF'FFFF;
+
+    using TileCallback = std::function<void(std::uint32_t tile_index, std::vector<std::uint32_t> const& escape_times)>;
+
+public:
+    // Continues the journal of the same render, otherwise starts a new one.
+    // The tiles already in the journal are passed to the callback
+    RenderJournal(std::string file_path, Header const& header, std::chrono::milliseconds sync_interval,
+                  TileCallback const& callbackFinishedTile);
+    ~RenderJournal();
+
+    RenderJournal(RenderJournal const&) = delete;
+    RenderJournal& operator =(RenderJournal const&) = delete;
+
+    // Thread safe
+    void append(std::uint32_t tile_index, std::vector<std::uint32_t> const& escape_times);
+
+    // Flushes the buffers and the OS cache to the disk
+    void sync();
+
+    // Appends and syncs, the wait for the file lock included
+    [[nodiscard]] std::chrono::duration<double> spentTime() const;
+
+private:
+    // Size of the valid part of the journal, zero when it belongs to another render
+    std::uintmax_t replay(Header const& header, TileCallback const& callbackFinishedTile);
+
+private:
+    std::string file_path;
+    std::mutex file_mutex;
+    std::FILE* file = nullptr;
+    std::chrono::milliseconds sync_interval;
+    std::chrono::steady_clock::time_point last_sync;
+    std::chrono::duration<double> spent_time { };
+};
+
+#endif //MANDELBROT_CPP_RENDERJOURNAL_H
@@ -0,0 +1,272 @@
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "TileServer.h"
+
+namespace
+{
+    constexpr std::size_t max_request_size = 8192;
+
+    // How often the connection threads check for a stop while no client connects
+    const sf::Time accept_poll_interval = sf::milliseconds(100);
+
+    std::atomic<bool> is_stop_signal_received = false;
+
+    void onStopSignal(int)
+    {
+        is_stop_signal_received.store(true);
+    }
+
+    const char* sourceName(TileServer::TileSource source)
+    {
+        switch (source)
+        {
+            case TileServer::TileSource::cache: return "cache";
+            case TileServer::TileSource::coalesced: return "coalesced";
+            case TileServer::TileSource::render: return "render";
+        }
+        return "";
+    }
+
+    void sendResponse(sf::TcpSocket& socket, std::string_view status, std::string_view content_type,
+                      void const* body, std::size_t body_size, std::string_view extra_headers = { })
+    {
+        std::string header = std::format("HTTP/1.1 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\n{}"
+                                         "Connection: close\r\n\r\n",
+                                         status, content_type, body_size, extra_headers);
+        if (socket.send(header.data(), header.size()) == sf::Socket::Done && body_size != 0)
+        {
+            socket.send(body, body_size);
+        }
+    }
+
+    void sendText(sf::TcpSocket& socket, std::string_view status, std::string_view text)
+    {
+        sendResponse(socket, status, "text/plain", text.data(), text.size());
+    }
+}
+
+std::size_t TileKeyHash::operator ()(TileKey const& key) const
+{
+    std::size_t hash = std::hash<long long>()(key.x);
+    hash = hash * 31 + std::hash<long long>()(key.y);
+    return hash * 31 + std::hash<int>()(key.z);
+}
+
+std::optional<TileKey> parseTilePath(std::string_view path)
+{
+    TileKey key { };
+    int parsed_length = 0;
+    std::string path_string(path);
+    if (std::sscanf(path_string.c_str(), "/%d/%lld/%lld.png%n", &key.z, &key.x, &key.y, &parsed_length) != 3 ||
+        std::size_t(parsed_length) != path_string.size())
+    {
+        return std::nullopt;
+    }
+    return key;
+}
+
+TileServer::TileServer(ProgramConfig const& program_config)
+    : config { program_config.tile_server_config }
+    , iterations_limit { program_config.iterations_limit }
+    , calc_method { program_config.calc_method }
+    , color_table { program_config.color_table_config }
+{ }
+
+void TileServer::listen()
+{
+    if (listener.listen(config.port) != sf::Socket::Done)
+    {
+        throw std::runtime_error(std::format("Can't listen on the port {}", config.port));
+    }
+
+    // Every connection thread waits on the listener, the ones that lose an accept go back to waiting
+    listener.setBlocking(false);
+    is_listening = true;
+}
+
+void TileServer::run()
+{
+    if (!is_listening)
+    {
+        listen();
+    }
+    std::clog << std::format("Serving tiles on http://localhost:{}/{{z}}/{{x}}/{{y}}.png\n", config.port);
+
+    is_stop_signal_received = false;
+    auto previous_interrupt_handler = std::signal(SIGINT, onStopSignal);
+    auto previous_terminate_handler = std::signal(SIGTERM, onStopSignal);
+
+    std::vector<std::thread> connection_threads;
+    for (std::size_t i = 0; i != config.connection_threads_count; ++i)
+    {
+        connection_threads.emplace_back(&TileServer::serveConnections, this);
+    }
+    for (std::thread& connection_thread: connection_threads)
+    {
+        connection_thread.join();
+    }
+
+    std::signal(SIGINT, previous_interrupt_handler);
+    std::signal(SIGTERM, previous_terminate_handler);
+    listener.close();
+    is_listening = false;
+    std::lock_guard lock(tiles_mutex);
+    cached_tiles_by_key.clear();
+    cached_tiles.clear();
+    std::clog << std::format("Tile server stopped after {} connections\n", served_requests_count.load());
+}
+
+void TileServer::stop()
+{
+    is_stopping = true;
+}
+
+bool TileServer::isStopping() const
+{
+    return is_stopping || is_stop_signal_received;
+}
+
+TileServer::Tile TileServer::tile(TileKey key)
+{
+    std::promise<EncodedTile> rendered_tile;
+    {
+        std::unique_lock lock(tiles_mutex);
+        if (auto cached = cached_tiles_by_key.find(key); cached != cached_tiles_by_key.end())
+        {
+            cached_tiles.splice(cached_tiles.begin(), cached_tiles, cached->second);
+            return { cached->second->second, TileSource::cache };
+        }
+        if (auto in_flight = in_flight_tiles.find(key); in_flight != in_flight_tiles.end())
+        {
+            std::shared_future<EncodedTile> in_flight_tile = in_flight->second;
+            lock.unlock();
+            return { in_flight_tile.get(), TileSource::coalesced };
+        }
+        in_flight_tiles.emplace(key, rendered_tile.get_future().share());
+    }
+
+    EncodedTile png;
+    try
+    {
+        png = renderTile(key);
+    } catch (...)
+    {
+        std::lock_guard lock(tiles_mutex);
+        in_flight_tiles.erase(key);
+        rendered_tile.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard lock(tiles_mutex);
+        cached_tiles.emplace_front(key, png);
+        cached_tiles_by_key[key] = cached_tiles.begin();
+        if (cached_tiles.size() > config.max_cached_tiles)
+        {
+            cached_tiles_by_key.erase(cached_tiles.back().first);
+            cached_tiles.pop_back();
+        }
+        in_flight_tiles.erase(key);
+    }
+    rendered_tile.set_value(png);
+    return { png, TileSource::render };
+}
+
+void TileServer::serveConnections()
+{
+    sf::SocketSelector selector;
+    selector.add(listener);
+    while (!isStopping())
+    {
+        sf::TcpSocket socket;
+        if (!selector.wait(accept_poll_interval) || listener.accept(socket) != sf::Socket::Done)
+        {
+            continue;
+        }
+        handleConnection(socket);
+        std::size_t served_count = ++served_requests_count;
+        if (config.max_requests_count != 0 && served_count >= config.max_requests_count)
+        {
+            stop();
+        }
+    }
+}
+
+void TileServer::handleConnection(sf::TcpSocket& socket)
+{
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < max_request_size)
+    {
+        std::size_t received = 0;
+        if (socket.receive(buffer, sizeof(buffer), received) != sf::Socket::Done)
+        {
+            return;
+        }
+        request.append(buffer, received);
+    }
+
+    std::istringstream request_line(request);
+    std::string method, path;
+    request_line >> method >> path;
+    std::optional<TileKey> key = parseTilePath(path);
+    if (method != "GET" || !key)
+    {
+        sendText(socket, "404 Not Found", "Expected GET /{z}/{x}/{y}.png\n");
+        return;
+    }
+    long long tiles_per_side = 1LL << std::clamp(key->z, 0, 62);
+    if (key->z < 0 || key->z > config.max_zoom || key->x < 0 || key->y < 0 ||
+        key->x >= tiles_per_side || key->y >= tiles_per_side)
+    {
+        sendText(socket, "404 Not Found", "No such tile\n");
+        return;
+    }
+
+    try
+    {
+        Tile found_tile = tile(*key);
+        sendResponse(socket, "200 OK", "image/png", found_tile.png->data(), found_tile.png->size(),
+                     std::format("X-Tile-Source: {}\r\n", sourceName(found_tile.source)));
+    } catch (std::exception const& e)
+    {
+        sendText(socket, "500 Internal Server Error", e.what());
+    }
+}
+
+TileServer::EncodedTile TileServer::renderTile(TileKey key)
+{
+    Real tile_plane_size = config.world_size / std::ldexp(Real(1), key.z);
+    Real re_min = config.world_top_left.re + Real(key.x) * tile_plane_size;
+    Real im_top = config.world_top_left.im - Real(key.y) * tile_plane_size;
+    auto size = int(config.tile_size);
+    // Screen rows grow with the imaginary part as in the other views, the image rows are flipped below
+    Axis axis { PlaneBorders<Real> { MinMax<Real> { re_min, re_min + tile_plane_size },
+                                     MinMax<Real> { im_top - tile_plane_size, im_top }},
+                PlaneBorders<int> { MinMax<int> { 0, size }, MinMax<int> { 0, size }}};
+    auto iterations_count = std::size_t(iterations_limit.clamp(
+        int(config.base_iterations_count + config.iterations_per_zoom * std::size_t(key.z))));
+
+    sf::Image image;
+    image.create(config.tile_size, config.tile_size);
+    {
+        std::lock_guard lock(render_mutex);
+        calc_method->calcFractal(iterations_count, axis, [this, &image, size](std::size_t spent_iterations, int px, int py)
+        {
+            // Slippy map tiles have the north at the top
+            image.setPixel(unsigned(px), unsigned(size - 1 - py), color_table.colorOf(spent_iterations));
+        });
+    }
+
+    auto png = std::make_shared<std::vector<sf::Uint8>>();
+    if (!image.saveToMemory(*png, "png"))
+    {
+        throw std::runtime_error("Can't encode the tile");
+    }
+    return png;
+}
@@ -0,0 +1,93 @@
+#ifndef MANDELBROT_CPP_TILESERVER_H
+#define MANDELBROT_CPP_TILESERVER_H
+
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../Fractal/Config.h"
+#include "../Fractal/ColorTable.h"
+
+struct TileKey
+{
+    int z;
+    long long x, y;
+
+    bool operator ==(TileKey const&) const = default;
+};
+
+struct TileKeyHash
+{
+    std::size_t operator ()(TileKey const& key) const;
+};
+
+// "/{z}/{x}/{y}.png"
+std::optional<TileKey> parseTilePath(std::string_view path);
+
+// Answers GET /{z}/{x}/{y}.png over HTTP/1.1 with PNG tiles.
+// Duplicate requests of a tile being rendered wait for that render, the encoded tiles are kept in a LRU cache.
+// Tiles are rendered one at a time by the calc method on the whole thread pool, the encoding overlaps the next render
+class TileServer
+{
+public:
+    enum class TileSource
+    {
+        cache, coalesced, render
+    };
+
+    using EncodedTile = std::shared_ptr<std::vector<sf::Uint8> const>;
+
+    struct Tile
+    {
+        EncodedTile png;
+        TileSource source;
+    };
+
+public:
+    explicit TileServer(ProgramConfig const& program_config);
+
+    // Throws when the port is taken. run() listens by itself when not yet
+    void listen();
+
+    // Blocks until stop(), a SIGINT or SIGTERM, or config.max_requests_count connections.
+    // The connections are served by connection_threads_count threads, the cached tiles are dropped on return
+    void run();
+
+    // From any thread: run() returns once the connections being served are answered
+    void stop();
+
+    Tile tile(TileKey key);
+
+private:
+    [[nodiscard]] bool isStopping() const;
+    void serveConnections();
+    void handleConnection(sf::TcpSocket& socket);
+    [[nodiscard]] EncodedTile renderTile(TileKey key);
+
+private:
+    TileServerConfig config;
+    MinMax<int> iterations_limit;
+    std::shared_ptr<FractalCalcMethod> calc_method;
+    ColorTable color_table;
+    sf::TcpListener listener;
+    bool is_listening = false;
+    std::atomic<bool> is_stopping = false;
+    std::atomic<std::size_t> served_requests_count = 0;
+
+    std::mutex tiles_mutex;
+    // The most recently used first
+    std::list<std::pair<TileKey, EncodedTile>> cached_tiles;
+    std::unordered_map<TileKey, decltype(cached_tiles)::iterator, TileKeyHash> cached_tiles_by_key;
+    std::unordered_map<TileKey, std::shared_future<EncodedTile>, TileKeyHash> in_flight_tiles;
+
+    // Calc methods keep per-frame state and the main thread joins the pool through a single worker
+    std::mutex render_mutex;
+};
+
+#endif //MANDELBROT_CPP_TILESERVER_H
@@ -0,0 +1,21 @@
+#include <algorithm>
+#include "CommandLine.h"
+
+CommandLine::CommandLine(int argc, char* argv[])
+    : args(argv + std::min(argc, 1), argv + argc)
+{ }
+
+bool CommandLine::hasFlag(std::string_view flag) const
+{
+    return std::find(args.begin(), args.end(), flag) != args.end();
+}
+
+std::optional<std::string> CommandLine::value(std::string_view flag) const
+{
+    auto flag_it = std::find(args.begin(), args.end(), flag);
+    if (flag_it == args.end() || std::next(flag_it) == args.end())
+    {
+        return std::nullopt;
+    }
+    return *std::next(flag_it);
+}
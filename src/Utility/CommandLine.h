@@ -0,0 +1,23 @@
+#ifndef MANDELBROT_CPP_COMMANDLINE_H
+#define MANDELBROT_CPP_COMMANDLINE_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <optional>
+
+class CommandLine
+{
+public:
+    CommandLine(int argc, char* argv[]);
+
+    [[nodiscard]] bool hasFlag(std::string_view flag) const;
+
+    // Value that follows the flag: "--flag value"
+    [[nodiscard]] std::optional<std::string> value(std::string_view flag) const;
+
+private:
+    std::vector<std::string> args;
+};
+
+#endif //MANDELBROT_CPP_COMMANDLINE_H
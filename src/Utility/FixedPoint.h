@@ -0,0 +1,161 @@
+#ifndef MANDELBROT_CPP_FIXEDPOINT_H
+#define MANDELBROT_CPP_FIXEDPOINT_H
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <gmpxx.h>
+
+// __extension__ keeps -pedantic quiet about the GCC/Clang 128-bit integer
+__extension__ typedef unsigned __int128 UInt128;
+
+// Signed two's complement fixed-point number of Limbs 64-bit words (the lowest word first).
+// The escape-time iteration keeps |z| small, so the exponent of a floating type is not needed:
+// 8 integer bits hold every intermediate value before the |z|^2 > 4 check, the rest is the fraction.
+template<std::size_t Limbs>
+class FixedPoint
+{
+public:
+    static_assert(Limbs >= 2, "At least 128 bits");
+
+    static constexpr int integer_bits = 8;
+    static constexpr int fraction_bits = 64 * int(Limbs) - integer_bits;
+
+    FixedPoint() = default;
+
+    explicit FixedPoint(int value)
+    {
+        limbs[Limbs - 1] = std::uint64_t(std::int64_t(value)) << (64 - integer_bits);
+    }
+
+    static FixedPoint fromReal(long double value)
+    {
+        FixedPoint result;
+        long double rest = std::ldexp(std::fabs(value), 64 - integer_bits);
+        for (std::size_t i = Limbs; i-- != 0 && rest != 0;)
+        {
+            long double limb = std::floor(rest);
+            result.limbs[i] = static_cast<std::uint64_t>(limb);
+            rest = std::ldexp(rest - limb, 64);
+        }
+        return value < 0 ? -result : result;
+    }
+
+    static FixedPoint fromMpf(mpf_class const& value)
+    {
+        mpf_class scaled(0, value.get_prec());
+        mpf_mul_2exp(scaled.get_mpf_t(), mpf_class(abs(value)).get_mpf_t(), fraction_bits);
+        mpz_class magnitude(scaled);
+
+        FixedPoint result;
+        std::size_t written_limbs = 0;
+        mpz_export(result.limbs.data(), &written_limbs, -1, sizeof(std::uint64_t), 0, 0, magnitude.get_mpz_t());
+        return value < 0 ? -result : result;
+    }
+
+    [[nodiscard]] bool isNegative() const
+    {
+        return std::int64_t(limbs[Limbs - 1]) < 0;
+    }
+
+    FixedPoint operator -() const
+    {
+        FixedPoint result;
+        UInt128 carry = 1;
+        for (std::size_t i = 0; i != Limbs; ++i)
+        {
+            carry += ~limbs[i];
+            result.limbs[i] = std::uint64_t(carry);
+            carry >>= 64;
+        }
+        return result;
+    }
+
+    friend FixedPoint operator +(FixedPoint const& a, FixedPoint const& b)
+    {
+        FixedPoint result;
+        UInt128 carry = 0;
+        for (std::size_t i = 0; i != Limbs; ++i)
+        {
+            carry += static_cast<UInt128>(a.limbs[i]) + b.limbs[i];
+            result.limbs[i] = std::uint64_t(carry);
+            carry >>= 64;
+        }
+        return result;
+    }
+
+    friend FixedPoint operator -(FixedPoint const& a, FixedPoint const& b)
+    {
+        return a + -b;
+    }
+
+    // Full product of the magnitudes by 64x64->128 multiplies, shifted back by fraction_bits
+    friend FixedPoint operator *(FixedPoint const& a, FixedPoint const& b)
+    {
+        bool is_negative = a.isNegative() != b.isNegative();
+        FixedPoint a_abs = a.isNegative() ? -a : a;
+        FixedPoint b_abs = b.isNegative() ? -b : b;
+
+        std::array<std::uint64_t, 2 * Limbs> product { };
+        for (std::size_t i = 0; i != Limbs; ++i)
+        {
+            UInt128 carry = 0;
+            for (std::size_t j = 0; j != Limbs; ++j)
+            {
+                carry += static_cast<UInt128>(a_abs.limbs[i]) * b_abs.limbs[j] + product[i + j];
+                product[i + j] = std::uint64_t(carry);
+                carry >>= 64;
+            }
+            product[i + Limbs] = std::uint64_t(carry);
+        }
+
+        constexpr std::size_t limb_shift = fraction_bits / 64;
+        constexpr int bit_shift = fraction_bits % 64;
+        FixedPoint result;
+        for (std::size_t i = 0; i != Limbs; ++i)
+        {
+            result.limbs[i] = product[limb_shift + i] >> bit_shift |
+                              (bit_shift != 0 ? product[limb_shift + i + 1] << (64 - bit_shift) : 0);
+        }
+        return is_negative ? -result : result;
+    }
+
+    friend FixedPoint operator *(FixedPoint const& a, unsigned factor)
+    {
+        FixedPoint a_abs = a.isNegative() ? -a : a;
+        FixedPoint result;
+        UInt128 carry = 0;
+        for (std::size_t i = 0; i != Limbs; ++i)
+        {
+            carry += static_cast<UInt128>(a_abs.limbs[i]) * factor;
+            result.limbs[i] = std::uint64_t(carry);
+            carry >>= 64;
+        }
+        return a.isNegative() ? -result : result;
+    }
+
+    friend bool operator >(FixedPoint const& a, FixedPoint const& b)
+    {
+        if (a.limbs[Limbs - 1] != b.limbs[Limbs - 1])
+        {
+            return std::int64_t(a.limbs[Limbs - 1]) > std::int64_t(b.limbs[Limbs - 1]);
+        }
+        for (std::size_t i = Limbs - 1; i-- != 0;)
+        {
+            if (a.limbs[i] != b.limbs[i])
+            {
+                return a.limbs[i] > b.limbs[i];
+            }
+        }
+        return false;
+    }
+
+private:
+    std::array<std::uint64_t, Limbs> limbs { };
+};
+
+using Fixed128 = FixedPoint<2>;
+using Fixed192 = FixedPoint<3>;
+using Fixed256 = FixedPoint<4>;
+
+#endif //MANDELBROT_CPP_FIXEDPOINT_H
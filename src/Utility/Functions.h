@@ -2,7 +2,10 @@
 #define MANDELBROT_CPP_FUNCTIONS_H
 
 #include <gmpxx.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <vector>
 #include <SFML/Graphics.hpp>
 
 template<class To, class From>
@@ -43,5 +46,12 @@ auto check_speed(auto f) {
     return std::chrono::duration_cast<std::chrono::milliseconds>(b - a).count();
 }
 
+// Nearest rank, rank in [0, 100]
+inline double percentile(std::vector<double> values, double rank)
+{
+    std::sort(values.begin(), values.end());
+    auto index = std::size_t(std::ceil(rank / 100 * double(values.size())));
+    return values[std::clamp<std::size_t>(index, 1, values.size()) - 1];
+}
 
 #endif //MANDELBROT_CPP_FUNCTIONS_H
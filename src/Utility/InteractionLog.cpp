@@ -0,0 +1,52 @@
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include "InteractionLog.h"
+
+InteractionRecorder::InteractionRecorder(std::string const& file_path)
+    : file { file_path }
+    , start { std::chrono::steady_clock::now() }
+{
+    if (!file)
+    {
+        throw std::runtime_error("Can't write the interaction log " + file_path);
+    }
+    file << std::setprecision(std::numeric_limits<Real>::max_digits10);
+}
+
+void InteractionRecorder::record(std::vector<std::string> const& actions, Axis const& axis, int iterations_count)
+{
+    auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::string action;
+    for (std::string const& frame_action: actions)
+    {
+        action += (action.empty() ? "" : "+") + frame_action;
+    }
+    PlaneBorders<Real> const& borders = axis.cartesian_borders;
+    file << time.count() << ' ' << action << ' '
+         << borders.x.min << ' ' << borders.x.max << ' ' << borders.y.min << ' ' << borders.y.max << ' '
+         << iterations_count << std::endl;
+}
+
+std::vector<InteractionRecord> loadInteractions(std::string const& file_path)
+{
+    std::ifstream file { file_path };
+    if (!file)
+    {
+        throw std::runtime_error("Can't read the interaction log " + file_path);
+    }
+
+    std::vector<InteractionRecord> records;
+    long long time_us = 0;
+    std::string action;
+    Real x_min = 0, x_max = 0, y_min = 0, y_max = 0;
+    int iterations_count = 0;
+    while (file >> time_us >> action >> x_min >> x_max >> y_min >> y_max >> iterations_count)
+    {
+        records.push_back(InteractionRecord {
+            std::chrono::microseconds(time_us), action,
+            PlaneBorders<Real> { MinMax<Real> { x_min, x_max }, MinMax<Real> { y_min, y_max }},
+            iterations_count });
+    }
+    return records;
+}
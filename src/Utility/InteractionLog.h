@@ -0,0 +1,34 @@
+#ifndef MANDELBROT_CPP_INTERACTIONLOG_H
+#define MANDELBROT_CPP_INTERACTIONLOG_H
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Types.h"
+
+// User actions and the view they produced: "<time, us> <action> <x min> <x max> <y min> <y max> <iterations>".
+// The actions handled before the same frame are joined by '+' into one action, e.g. "wheel-zoom-in+wheel-zoom-in"
+struct InteractionRecord
+{
+    std::chrono::microseconds time;
+    std::string action;
+    PlaneBorders<Real> cartesian_borders;
+    int iterations_count;
+};
+
+class InteractionRecorder
+{
+public:
+    explicit InteractionRecorder(std::string const& file_path);
+
+    void record(std::vector<std::string> const& actions, Axis const& axis, int iterations_count);
+
+private:
+    std::ofstream file;
+    std::chrono::steady_clock::time_point start;
+};
+
+std::vector<InteractionRecord> loadInteractions(std::string const& file_path);
+
+#endif //MANDELBROT_CPP_INTERACTIONLOG_H
@@ -46,3 +46,9 @@ Real Axis::screenToCartesianY(int y) const
 {
     return screen_borders.y.lerp(y, cartesian_borders.y);
 }
+
+Real Axis::pixelSize() const
+{
+    return std::min(std::abs(screenToCartesianX(1) - screenToCartesianX(0)),
+                    std::abs(screenToCartesianY(1) - screenToCartesianY(0)));
+}
@@ -12,6 +12,8 @@ using Real = long double;
 struct Complex
 {
     Real re, im;
+
+    bool operator ==(Complex const&) const = default;
 };
 
 template<class T>
@@ -50,6 +52,8 @@ struct MinMax
         return sf::Color { r, g, b };
     }
 
+    bool operator ==(MinMax const&) const = default;
+
     T min = { };
     T max = { };
 };
@@ -63,6 +67,8 @@ struct PlaneBorders
         , y(y)
     { }
 
+    bool operator ==(PlaneBorders const&) const = default;
+
     MinMax<T> x;
     MinMax<T> y;
 };
@@ -73,6 +79,9 @@ public:
     [[nodiscard]] Real screenToCartesianX(int x) const;
     [[nodiscard]] Real screenToCartesianY(int y) const;
 
+    // The smaller of the distances between adjacent pixels, the precision tiers are chosen by it
+    [[nodiscard]] Real pixelSize() const;
+
     PlaneBorders<Real> cartesian_borders;
     PlaneBorders<int> screen_borders;
 };
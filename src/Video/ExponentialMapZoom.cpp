@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <numbers>
+#include "ExponentialMapZoom.h"
+#include "../Fractal/TaskIterators.h"
+#include "../Multithreading/ThreadPoolInstance.h"
+
+namespace
+{
+    sf::Color blend(sf::Color a, sf::Color b, Real t)
+    {
+        auto channel = [t](sf::Uint8 from, sf::Uint8 to)
+        {
+            return sf::Uint8(std::lround(Real(from) + (Real(to) - Real(from)) * t));
+        };
+        return sf::Color { channel(a.r, b.r), channel(a.g, b.g), channel(a.b, b.b) };
+    }
+
+    Real startPixelSize(ZoomVideoConfig const& config)
+    {
+        return 2 * config.start_half_height / Real(config.frame_height);
+    }
+}
+
+ExponentialMapZoom::ExponentialMapZoom(ProgramConfig const& program_config)
+    : config { program_config.zoom_video_config }
+    , calc_method { program_config.calc_method }
+    , color_table { program_config.color_table_config }
+{
+    // One strip column per pixel on the circle through the frame corners
+    Real half_diagonal = std::hypot(Real(config.frame_width), Real(config.frame_height)) / 2;
+    columns = int(std::ceil(2 * std::numbers::pi_v<Real> * half_diagonal));
+    radial_step = 2 * std::numbers::pi_v<Real> / Real(columns);
+
+    // From the corners of the first frame down to half a pixel of the last one
+    max_radius = half_diagonal * startPixelSize(config);
+    Real min_radius = startPixelSize(config) / config.zoom_depth / 2;
+    rows = int(std::ceil(std::log(max_radius / min_radius) / radial_step)) + 1;
+}
+
+void ExponentialMapZoom::calculate()
+{
+    strip.resize(std::size_t(rows) * std::size_t(columns));
+    auto row_task = [this](int row)
+    {
+        Real radius = max_radius * std::exp(-Real(row) * radial_step);
+        auto iterations_count = config.base_iterations_count +
+                                std::size_t(Real(config.iterations_per_decade) * std::log10(max_radius / radius));
+
+        // Adjacent points of the row are radius * radial_step apart, the precision tier follows that
+        FractalCalcMethod const& row_calc_method = calc_method->methodForPixelSize(radius * radial_step);
+        for (int column = 0; column != columns; ++column)
+        {
+            Real angle = radial_step * Real(column);
+            Complex c { config.center.re + radius * std::cos(angle), config.center.im + radius * std::sin(angle) };
+            strip[std::size_t(row) * std::size_t(columns) + std::size_t(column)] =
+                color_table.colorOf(row_calc_method.calcPoint(iterations_count, c));
+        }
+    };
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto rows_latch = thread_pool.addTasks(RowTasksIterator<decltype(row_task)> { row_task, rows });
+    thread_pool.joinMainToWorkers(*rows_latch);
+}
+
+void ExponentialMapZoom::renderFrames(std::string const& directory, std::ostream& log)
+{
+    std::filesystem::create_directories(directory);
+    using Ms = std::chrono::duration<double, std::milli>;
+
+    auto strip_begin = std::chrono::steady_clock::now();
+    calculate();
+    Ms strip_time = std::chrono::steady_clock::now() - strip_begin;
+
+    unsigned frames_count = std::max(config.frames_per_second * config.duration_seconds, 2u);
+    sf::Image frame;
+    frame.create(config.frame_width, config.frame_height);
+    Ms resample_time { };
+    for (unsigned i = 0; i != frames_count; ++i)
+    {
+        Real depth = std::pow(config.zoom_depth, Real(i) / Real(frames_count - 1));
+        auto resample_begin = std::chrono::steady_clock::now();
+        renderFrame(frame, startPixelSize(config) / depth);
+        resample_time += std::chrono::steady_clock::now() - resample_begin;
+
+        if (!frame.saveToFile(std::format("{}/frame_{:05}.png", directory, i)))
+        {
+            throw std::runtime_error("Can't write the frames into " + directory);
+        }
+    }
+
+    double frame_pixels = double(config.frame_width) * config.frame_height;
+    log << std::format("Strip {}x{}: {:.1f} Mpx (as {:.1f} frames) in {:.0f} ms\n", columns, rows,
+                       double(stripPixelsCount()) / 1e6, double(stripPixelsCount()) / frame_pixels, strip_time.count());
+    log << std::format("{} frames resampled in {:.0f} ms, computing them directly is {:.1f} Mpx\n", frames_count,
+                       resample_time.count(), frame_pixels * frames_count / 1e6);
+}
+
+std::size_t ExponentialMapZoom::stripPixelsCount() const
+{
+    return std::size_t(rows) * std::size_t(columns);
+}
+
+sf::Color ExponentialMapZoom::sample(Real dx, Real dy) const
+{
+    Real radius = std::hypot(dx, dy);
+    Real row = radius > 0 ? std::log(max_radius / radius) / radial_step : Real(rows - 1);
+    row = std::clamp(row, Real(0), Real(rows - 1));
+    Real column = std::atan2(dy, dx) / radial_step;
+    if (column < 0)
+    {
+        column += Real(columns);
+    }
+
+    int row_0 = std::min(int(row), rows - 1);
+    int row_1 = std::min(row_0 + 1, rows - 1);
+    int column_0 = int(column) % columns;
+    int column_1 = (column_0 + 1) % columns;
+    auto at = [this](int strip_row, int strip_column)
+    {
+        return strip[std::size_t(strip_row) * std::size_t(columns) + std::size_t(strip_column)];
+    };
+
+    Real column_fraction = column - std::floor(column);
+    sf::Color outer = blend(at(row_0, column_0), at(row_0, column_1), column_fraction);
+    sf::Color inner = blend(at(row_1, column_0), at(row_1, column_1), column_fraction);
+    return blend(outer, inner, row - Real(row_0));
+}
+
+void ExponentialMapZoom::renderFrame(sf::Image& frame, Real pixel_size) const
+{
+    auto width = int(config.frame_width);
+    auto height = int(config.frame_height);
+    auto row_task = [this, &frame, pixel_size, width, height](int py)
+    {
+        // The imaginary axis goes up
+        Real dy = (Real(height) / 2 - Real(py) - Real(0.5)) * pixel_size;
+        for (int px = 0; px != width; ++px)
+        {
+            Real dx = (Real(px) + Real(0.5) - Real(width) / 2) * pixel_size;
+            frame.setPixel(unsigned(px), unsigned(py), sample(dx, dy));
+        }
+    };
+    auto& thread_pool = ThreadPoolSimpleInstance::get();
+    auto rows_latch = thread_pool.addTasks(RowTasksIterator<decltype(row_task)> { row_task, height });
+    thread_pool.joinMainToWorkers(*rows_latch);
+}
@@ -0,0 +1,45 @@
+#ifndef MANDELBROT_CPP_EXPONENTIALMAPZOOM_H
+#define MANDELBROT_CPP_EXPONENTIALMAPZOOM_H
+
+#include <SFML/Graphics.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../Fractal/Config.h"
+#include "../Fractal/ColorTable.h"
+
+// Log-polar strip around the zoom center: row k is the circle of radius max_radius * exp(-k * step),
+// column j is the angle 2 * pi * j / columns. The radial step equals the angular one, so the strip pixels
+// stay square at any depth and the strip covers every frame of the zoom once.
+// A frame is resampled from the strip rows between its corners and its central pixel
+class ExponentialMapZoom
+{
+public:
+    explicit ExponentialMapZoom(ProgramConfig const& program_config);
+
+    // Computes the strip on the thread pool
+    void calculate();
+
+    // frame_00000.png ... into the directory, encode with e.g. ffmpeg -i frame_%05d.png
+    void renderFrames(std::string const& directory, std::ostream& log);
+
+    [[nodiscard]] std::size_t stripPixelsCount() const;
+
+private:
+    [[nodiscard]] sf::Color sample(Real dx, Real dy) const;
+
+    void renderFrame(sf::Image& frame, Real pixel_size) const;
+
+private:
+    ZoomVideoConfig config;
+    std::shared_ptr<FractalCalcMethod> calc_method;
+    ColorTable color_table;
+
+    int columns;
+    int rows;
+    Real max_radius;
+    Real radial_step;
+    std::vector<sf::Color> strip;
+};
+
+#endif //MANDELBROT_CPP_EXPONENTIALMAPZOOM_H
@@ -1,18 +1,152 @@
 #include <iostream>
+#include <format>
 #include "MainWindow.h"
+#include "Utility/CommandLine.h"
+#include "Multithreading/ThreadPoolInstance.h"
+#include "Multithreading/PerfProfiler.h"
+#include "Fractal/AutoTuner.h"
+#include "Benchmark/ScalingBenchmark.h"
+#include "Benchmark/PrecisionBenchmark.h"
+#include "Benchmark/ReplayBenchmark.h"
+#include "Benchmark/AtlasBenchmark.h"
+#include "Benchmark/TileLoadBenchmark.h"
+#include "Server/TileServer.h"
+#include "Video/ExponentialMapZoom.h"
+#include "Fractal/BuddhabrotEngine.h"
+#include "Poster/PosterRenderer.h"
 
-int main()
+int main(int argc, char* argv[])
 {
     try
     {
+        CommandLine command_line(argc, argv);
+
         sf::Color deep_blue = sf::Color(0, 60, 192);
         sf::Color gold = sf::Color(255, 140, 0);
 
         ProgramConfig program_config;
         program_config.color_table_config.color_range = { deep_blue, gold };
 
+        program_config.is_auto_iterations = command_line.hasFlag("--auto-iterations");
+        auto formula_name = command_line.value("--formula");
+        auto method_name = command_line.value("--calc-method");
+        bool is_calc_method_chosen = formula_name || method_name;
+        if (formula_name)
+        {
+            program_config.calc_method = makeCalcMethodByFormulaName(*formula_name, method_name.value_or("rows"));
+        }
+        else if (method_name)
+        {
+            program_config.calc_method = makeCalcMethodByName(*method_name);
+        }
+        if (auto workers_count = command_line.value("--workers"))
+        {
+            program_config.thread_pool_config.workers_count = std::stoul(*workers_count);
+        }
+        if (auto cpu_list = command_line.value("--affinity"))
+        {
+            program_config.thread_pool_config.cpu_affinity = parseCpuList(*cpu_list);
+        }
+        if (auto port = command_line.value("--port"))
+        {
+            program_config.tile_server_config.port = static_cast<unsigned short>(std::stoul(*port));
+        }
+        if (auto requests_count = command_line.value("--max-requests"))
+        {
+            program_config.tile_server_config.max_requests_count = std::stoul(*requests_count);
+        }
+        program_config.buddhabrot_config.is_anti = command_line.hasFlag("--anti");
+        program_config.buddhabrot_config.is_metropolis = !command_line.hasFlag("--uniform-sampling");
+        if (auto samples_count = command_line.value("--samples"))
+        {
+            program_config.buddhabrot_config.samples_count = std::stoull(*samples_count);
+        }
+        if (auto poster_size = command_line.value("--poster-size"))
+        {
+            std::size_t separator = poster_size->find('x');
+            program_config.poster_config.width = unsigned(std::stoul(poster_size->substr(0, separator)));
+            program_config.poster_config.height = unsigned(std::stoul(poster_size->substr(separator + 1)));
+        }
+        if (auto log_path = command_line.value("--record"))
+        {
+            program_config.interaction_log_path = *log_path;
+        }
+        ThreadPoolSimpleInstance::configure(program_config.thread_pool_config);
+        if (command_line.hasFlag("--perf"))
+        {
+            PerfProfiler::get().enable();
+        }
+
+        if (command_line.hasFlag("--bench-precision"))
+        {
+            runPrecisionBenchmark(std::cout);
+            PerfProfiler::get().report(std::cout);
+            return 0;
+        }
+
+        if (auto image_path = command_line.value("--buddhabrot"))
+        {
+            BuddhabrotEngine buddhabrot(program_config);
+            BuddhabrotEngine::Statistics statistics = buddhabrot.sample();
+            buddhabrot.saveImage(*image_path);
+            std::cout << std::format("{} samples (and {} to find the walk starts) in {:.2f} s: {:.0f} samples/s, "
+                                     "{:.1f}% contributing, {:.1f}% accepted\n",
+                                     statistics.samples_count, statistics.start_search_samples_count,
+                                     statistics.spent_time.count(),
+                                     statistics.samplesPerSecond(),
+                                     100.0 * double(statistics.contributing_samples_count) / double(statistics.samples_count),
+                                     100.0 * double(statistics.accepted_count) / double(statistics.samples_count));
+            return 0;
+        }
+
+        // Only the modes below use the calc method
+        if (!is_calc_method_chosen)
+        {
+            program_config.calc_method = makeTunedCalcMethod(program_config.tuning_profile_path,
+                                                             command_line.hasFlag("--retune"));
+        }
+        if (command_line.hasFlag("--bench-scaling"))
+        {
+            runScalingBenchmark(program_config, std::cout);
+            PerfProfiler::get().report(std::cout);
+            return 0;
+        }
+        if (command_line.hasFlag("--bench-atlas"))
+        {
+            runAtlasBenchmark(program_config, std::cout);
+            PerfProfiler::get().report(std::cout);
+            return 0;
+        }
+        if (auto image_path = command_line.value("--poster"))
+        {
+            PosterRenderer(program_config).render(*image_path, std::cout);
+            return 0;
+        }
+        if (auto directory = command_line.value("--zoom-video"))
+        {
+            ExponentialMapZoom(program_config).renderFrames(*directory, std::cout);
+            return 0;
+        }
+        if (command_line.hasFlag("--serve-tiles"))
+        {
+            TileServer(program_config).run();
+            return 0;
+        }
+        if (command_line.hasFlag("--bench-tiles"))
+        {
+            runTileLoadBenchmark(program_config, std::cout);
+            return 0;
+        }
+        if (auto log_path = command_line.value("--replay"))
+        {
+            runReplayBenchmark(program_config, *log_path, std::cout);
+            PerfProfiler::get().report(std::cout);
+            return 0;
+        }
+
         MainWindow mainWindow(program_config);
         mainWindow.startLoop();
+        PerfProfiler::get().report(std::clog);
 
     } catch (const std::exception& e)
     {